@@ -3,10 +3,12 @@
 #include <debug.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include "atomic.h"
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/workqueue.h"
 
 /* The code in this file is an interface to an ATA (IDE)
    controller.  It attempts to comply to [ATA-3]. */
@@ -57,8 +59,8 @@ struct disk {
 	bool is_ata;                /* 1=This device is an ATA disk. */
 	disk_sector_t capacity;     /* Capacity in sectors (if is_ata). */
 
-	long long read_cnt;         /* Number of sectors read. */
-	long long write_cnt;        /* Number of sectors written. */
+	int64_t read_cnt;           /* Number of sectors read. */
+	int64_t write_cnt;          /* Number of sectors written. */
 };
 
 /* An ATA channel (aka controller).
@@ -72,6 +74,8 @@ struct channel {
 	bool expecting_interrupt;   /* True if an interrupt is expected, false if
 								   any interrupt would be spurious. */
 	struct semaphore completion_wait;   /* Up'd by interrupt handler. */
+	int unexpected_cnt;         /* Spurious interrupts not yet reported. */
+	struct work report_work;    /* Reports them outside the handler. */
 
 	struct disk devices[2];     /* The devices on this channel. */
 };
@@ -95,6 +99,7 @@ static void select_device (const struct disk *);
 static void select_device_wait (const struct disk *);
 
 static void interrupt_handler (struct intr_frame *);
+static void report_unexpected (void *channel_);
 
 /* Initialize the disk subsystem and detect disks. */
 void
@@ -122,6 +127,8 @@ disk_init (void) {
 		lock_init (&c->lock);
 		c->expecting_interrupt = false;
 		sema_init (&c->completion_wait, 0);
+		c->unexpected_cnt = 0;
+		work_init (&c->report_work, report_unexpected, c);
 
 		/* Initialize devices. */
 		for (dev_no = 0; dev_no < 2; dev_no++) {
@@ -133,7 +140,8 @@ disk_init (void) {
 			d->is_ata = false;
 			d->capacity = 0;
 
-			d->read_cnt = d->write_cnt = 0;
+			atomic_store (&d->read_cnt, 0);
+			atomic_store (&d->write_cnt, 0);
 		}
 
 		/* Register interrupt handler. */
@@ -168,7 +176,8 @@ disk_print_stats (void) {
 			struct disk *d = disk_get (chan_no, dev_no);
 			if (d != NULL && d->is_ata)
 				printf ("%s: %lld reads, %lld writes\n",
-						d->name, d->read_cnt, d->write_cnt);
+						d->name, atomic_load (&d->read_cnt),
+						atomic_load (&d->write_cnt));
 		}
 	}
 }
@@ -222,7 +231,7 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
 	if (!wait_while_busy (d))
 		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
 	input_sector (c, buffer);
-	d->read_cnt++;
+	atomic_inc (&d->read_cnt);
 	lock_release (&c->lock);
 }
 
@@ -246,7 +255,7 @@ disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
 		PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
 	output_sector (c, buffer);
 	sema_down (&c->completion_wait);
-	d->write_cnt++;
+	atomic_inc (&d->write_cnt);
 	lock_release (&c->lock);
 }
 
@@ -448,20 +457,23 @@ output_sector (struct channel *c, const void *sector) {
 
 /* Low-level ATA primitives. */
 
-/* Wait up to 10 seconds for the controller to become idle, that
-   is, for the BSY and DRQ bits to clear in the status register.
+/* Wait up to 10 milliseconds for the controller to become idle,
+   that is, for the BSY and DRQ bits to clear in the status
+   register.  Each poll interval blocks rather than spins, and may
+   run longer than asked, so the timeout is measured against the
+   clock instead of by counting polls.
 
    As a side effect, reading the status register clears any
    pending interrupt. */
 static void
 wait_until_idle (const struct disk *d) {
-	int i;
+	uint64_t deadline = timer_now_ns () + 10 * 1000 * 1000;
 
-	for (i = 0; i < 1000; i++) {
+	do {
 		if ((inb (reg_status (d->channel)) & (STA_BSY | STA_DRQ)) == 0)
 			return;
 		timer_usleep (10);
-	}
+	} while (timer_now_ns () < deadline);
 
 	printf ("%s: idle timeout\n", d->name);
 }
@@ -521,24 +533,47 @@ interrupt_handler (struct intr_frame *f) {
 			if (c->expecting_interrupt) {
 				inb (reg_status (c));               /* Acknowledge interrupt. */
 				sema_up (&c->completion_wait);      /* Wake up waiter. */
-			} else
-				printf ("%s: unexpected interrupt\n", c->name);
+			} else {
+				/* Printing polls the serial port, so leave it to
+				   a worker rather than doing it here. */
+				c->unexpected_cnt++;
+				work_queue (&wq_default, &c->report_work);
+			}
 			return;
 		}
 
 	NOT_REACHED ();
 }
 
+/* Reports the spurious interrupts that CHANNEL_ has received
+   since the last report.  Runs in a worker thread. */
+static void
+report_unexpected (void *channel_) {
+	struct channel *c = channel_;
+	enum intr_level old_level;
+	int cnt;
+
+	old_level = intr_disable ();
+	cnt = c->unexpected_cnt;
+	c->unexpected_cnt = 0;
+	intr_set_level (old_level);
+
+	if (cnt == 1)
+		printf ("%s: unexpected interrupt\n", c->name);
+	else if (cnt > 1)
+		printf ("%s: %d unexpected interrupts\n", c->name, cnt);
+}
+
 static void
 inspect_read_cnt (struct intr_frame *f) {
 	struct disk * d = disk_get (f->R.rdx, f->R.rcx);
-	f->R.rax = d->read_cnt;
+	f->R.rax = atomic_load (&d->read_cnt);
 }
 
 static void
 inspect_write_cnt (struct intr_frame *f) {
 	struct disk * d = disk_get (f->R.rdx, f->R.rcx);
-	f->R.rax = d->write_cnt;
+	f->R.rax = atomic_load (&d->write_cnt);
 }
 
 /* Tool for testing disk r/w cnt. Calling this function via int 0x43 and int 0x44.
@@ -0,0 +1,139 @@
+#include "devices/rtc.h"
+#include <debug.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/io.h"
+
+/* This code is an interface to the MC146818A-compatible real
+   time clock found on PC motherboards.  See [MC146818A] for
+   hardware details.
+
+   Only the periodic interrupt is used.  It serves as the clock
+   event device for high-resolution timers: it is switched on
+   while any hrtimer is pending and off again once none are, so
+   it costs nothing when unused.  While no hrtimer is pending,
+   the tickless idle loop may instead run it at a slow rate, as a
+   wakeup source with a longer range than the 8254. */
+
+/* I/O register addresses. */
+#define CMOS_REG_SET	0x70    /* Selects CMOS register exposed by REG_IO. */
+#define CMOS_REG_IO	0x71    /* Contains the selected data byte. */
+
+/* Indexes of CMOS registers with real-time clock functions. */
+#define RTC_REG_A	0x0a    /* Divider and rate selection. */
+#define RTC_REG_B	0x0b    /* Interrupt enables and data format. */
+#define RTC_REG_C	0x0c    /* Interrupt flags, cleared by reading. */
+
+/* Register A: 32.768 kHz time base, rate 3 = 8192 Hz.  Rate R
+   gives 32768 >> (R - 1) Hz for R from 3 to 15, so the slowest
+   is 2 Hz. */
+#define RTCSA_DV	0x20
+#define RTCSA_RATE	0x03
+#define RTCSA_RATE_MIN	0x06    /* 1024 Hz, slowest wakeup is 2 Hz. */
+#define RTCSA_RATE_MAX	0x0f
+#define RTC_BASE_HZ	32768
+
+/* Register B: periodic interrupt enable. */
+#define RTCSB_PIE	0x40
+
+static intr_handler_func rtc_interrupt;
+static uint8_t cmos_read (uint8_t index);
+static void cmos_write (uint8_t index, uint8_t data);
+
+/* Programs the RTC periodic rate and registers its interrupt.
+   The periodic interrupt stays disabled until
+   rtc_periodic_start(). */
+void
+rtc_init (void) {
+	enum intr_level old_level = intr_disable ();
+
+	cmos_write (RTC_REG_A, RTCSA_DV | RTCSA_RATE);
+	cmos_write (RTC_REG_B, cmos_read (RTC_REG_B) & ~RTCSB_PIE);
+
+	/* The RTC raises no further interrupts until register C has
+	   been read, so clear anything left over from the BIOS. */
+	cmos_read (RTC_REG_C);
+
+	intr_register_ext (0x28, rtc_interrupt, "RTC");
+	intr_set_level (old_level);
+}
+
+/* Enables the periodic interrupt. */
+void
+rtc_periodic_start (void) {
+	enum intr_level old_level = intr_disable ();
+	cmos_write (RTC_REG_B, cmos_read (RTC_REG_B) | RTCSB_PIE);
+	intr_set_level (old_level);
+}
+
+/* Disables the periodic interrupt. */
+void
+rtc_periodic_stop (void) {
+	enum intr_level old_level = intr_disable ();
+	cmos_write (RTC_REG_B, cmos_read (RTC_REG_B) & ~RTCSB_PIE);
+	intr_set_level (old_level);
+}
+
+/* Runs the periodic interrupt at the slowest rate whose period
+   is at most MAX_NS nanoseconds, so that its first interrupt
+   arrives within MAX_NS.  Returns the period chosen, or 0, doing
+   nothing, if even the fastest wakeup rate is too slow.  Must not
+   be used while an hrtimer is pending; rtc_wakeup_stop() undoes
+   it. */
+uint64_t
+rtc_wakeup_start (uint64_t max_ns) {
+	enum intr_level old_level;
+	uint64_t period = 0;
+	int rate;
+
+	for (rate = RTCSA_RATE_MAX; rate >= RTCSA_RATE_MIN; rate--) {
+		period = (1000000000ULL << (rate - 1)) / RTC_BASE_HZ;
+		if (period <= max_ns)
+			break;
+	}
+	if (rate < RTCSA_RATE_MIN)
+		return 0;
+
+	old_level = intr_disable ();
+	cmos_write (RTC_REG_A, RTCSA_DV | rate);
+
+	/* A periodic flag left set from earlier would raise an
+	   interrupt as soon as it is enabled. */
+	cmos_read (RTC_REG_C);
+	cmos_write (RTC_REG_B, cmos_read (RTC_REG_B) | RTCSB_PIE);
+	intr_set_level (old_level);
+	return period;
+}
+
+/* Disables the periodic interrupt and restores the hrtimer
+   rate. */
+void
+rtc_wakeup_stop (void) {
+	enum intr_level old_level = intr_disable ();
+	cmos_write (RTC_REG_B, cmos_read (RTC_REG_B) & ~RTCSB_PIE);
+	cmos_write (RTC_REG_A, RTCSA_DV | RTCSA_RATE);
+	intr_set_level (old_level);
+}
+
+/* RTC interrupt handler. */
+static void
+rtc_interrupt (struct intr_frame *args UNUSED) {
+	cmos_read (RTC_REG_C);
+	hrtimer_interrupt ();
+}
+
+/* Returns the byte from CMOS register INDEX. */
+static uint8_t
+cmos_read (uint8_t index) {
+	outb (CMOS_REG_SET, index);
+	return inb (CMOS_REG_IO);
+}
+
+/* Writes DATA to CMOS register INDEX. */
+static void
+cmos_write (uint8_t index, uint8_t data) {
+	outb (CMOS_REG_SET, index);
+	outb (CMOS_REG_IO, data);
+}
@@ -3,10 +3,12 @@
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
+#include "devices/rtc.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "intrinsic.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -17,18 +19,88 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
-static struct list sleep_list; 
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* Hashed timing wheel.  A timer expiring at tick T lives in
+   wheel[T % TIMER_WHEEL_SIZE], so arming a timer is O(1) and each
+   tick only has to look at a single slot.  Timers more than one
+   revolution away share a slot with nearer ones and are simply
+   skipped until their tick comes around. */
+#define TIMER_WHEEL_SIZE 256    /* Must be a power of 2. */
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SIZE - 1)
+static struct list wheel[TIMER_WHEEL_SIZE];
+static int64_t wheel_ticks;     /* Last tick whose slot was run. */
+static size_t timer_cnt;        /* # of pending timers. */
+
+/* 8254 input frequency and the counter value for one tick. */
+#define PIT_HZ 1193180
+#define PIT_TICK_COUNT ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* Dynamic ticks.  If true, the idle thread stops the periodic
+   timer interrupt and instead programs the 8254 in one-shot mode
+   for the next timer deadline.  The counter is only 16 bits wide,
+   so a single one-shot period is at most TICKLESS_MAX_TICKS.
+   Longer stops, up to TICKLESS_LONG_MAX_TICKS, halt the 8254 and
+   wake on the RTC at a slow periodic rate instead; the ticks
+   missed meanwhile are counted from the TSC, and the 8254
+   one-shot is left for the final partial period.
+   Controlled by kernel command-line option "-tickless". */
+bool timer_tickless;
+#define TICKLESS_MAX_TICKS (0xffff / PIT_TICK_COUNT)
+#define TICKLESS_LONG_MAX_TICKS TIMER_WHEEL_SIZE
+static bool tick_stopped;       /* 8254 currently in one-shot mode? */
+static int64_t stopped_ticks;   /* Ticks covered by the one-shot count. */
+static bool tick_long;          /* 8254 halted, waiting on the RTC? */
+static uint64_t long_base_ns;   /* timer_now_ns() at the last tick
+                                   boundary before a long stop. */
+static long long tickless_cnt;  /* # of times the tick was stopped. */
+static long long long_stop_cnt; /* # of those that waited on the RTC. */
+static long long skipped_ticks; /* # of timer interrupts avoided. */
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* TSC clocksource.  timer_now_ns() converts TSC cycles since
+   TSC_BASE into nanoseconds as (cycles * tsc_ns_mult) >> 32, which
+   needs no division.  Until timer_calibrate() sets tsc_ns_mult the
+   clock only has tick resolution. */
+#define NS_PER_SEC 1000000000LL
+#define NS_PER_TICK (NS_PER_SEC / TIMER_FREQ)
+#define TSC_CALIBRATE_TICKS 5   /* Ticks to measure the TSC over. */
+static uint64_t tsc_hz;         /* TSC cycles per second. */
+static uint64_t tsc_ns_mult;    /* ns per cycle, 32.32 fixed point. */
+static uint64_t tsc_base;       /* TSC value at TSC_BASE_NS. */
+static uint64_t tsc_base_ns;    /* timer_now_ns() at calibration. */
+
+/* Pending hrtimers, in order of deadline. */
+static struct list hrtimers;
+
+/* Hrtimers only fire on the RTC periodic interrupt, so a blocked
+   sub-tick delay wakes up to RTC_PERIOD_NS late.  Delays shorter
+   than HRTIMER_SPIN_NS therefore spin on the TSC, and longer ones
+   block only until one RTC period before the deadline and spin
+   the rest, so that they are not late. */
+#define RTC_PERIOD_NS (NS_PER_SEC / RTC_PERIODIC_FREQ)
+#define HRTIMER_SPIN_NS (2 * RTC_PERIOD_NS)
+static long long hrtimer_sleep_cnt; /* # of sub-tick delays that blocked. */
+static long long tsc_spin_cnt;      /* # of sub-tick delays that spun. */
+
 static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
+static void timer_wheel_advance (int64_t now);
+static int64_t timer_next_expiry (int64_t limit);
+static void pit_set_periodic (void);
+static void pit_set_oneshot (uint16_t count);
+static void pit_halt (void);
+static void tick_catch_up (int64_t elapsed);
+static uint16_t pit_read_count (void);
+static void tsc_calibrate (void);
+static bool hrtimer_less (const struct list_elem *, const struct list_elem *,
+		void *aux);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
@@ -37,15 +109,14 @@ void
 timer_init (void) {
 	/* 8254 input frequency divided by TIMER_FREQ, rounded to
 	   nearest. */
-	
-	list_init(&sleep_list); //sleep_list 초기화
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+	for (int i = 0; i < TIMER_WHEEL_SIZE; i++)
+		list_init (&wheel[i]);
+	list_init (&hrtimers);
 
-	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
-	outb (0x40, count & 0xff);
-	outb (0x40, count >> 8);
+	pit_set_periodic ();
 
 	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
+	rtc_init ();
 }
 
 /* Calibrates loops_per_tick, used to implement brief delays. */
@@ -71,6 +142,41 @@ timer_calibrate (void) {
 			loops_per_tick |= test_bit;
 
 	printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+
+	tsc_calibrate ();
+	printf ("TSC clocksource: %'"PRIu64" kHz.\n", tsc_hz / 1000);
+}
+
+/* Measures the TSC frequency against the 8254 over
+   TSC_CALIBRATE_TICKS ticks and switches timer_now_ns() over to
+   the TSC. */
+static void
+tsc_calibrate (void) {
+	int64_t start;
+	uint64_t tsc_start, tsc_end;
+
+	ASSERT (intr_get_level () == INTR_ON);
+
+	/* Start right at a tick boundary. */
+	start = ticks;
+	while (ticks == start)
+		barrier ();
+	start = ticks;
+	tsc_start = rdtsc ();
+
+	while (ticks - start < TSC_CALIBRATE_TICKS)
+		barrier ();
+	tsc_end = rdtsc ();
+
+	tsc_hz = (tsc_end - tsc_start) * TIMER_FREQ / TSC_CALIBRATE_TICKS;
+	ASSERT (tsc_hz > 0);
+
+	/* Continue the tick-based clock from the boundary just seen,
+	   so timer_now_ns() never goes backward. */
+	tsc_base = tsc_end;
+	tsc_base_ns = (start + TSC_CALIBRATE_TICKS) * NS_PER_TICK;
+	barrier ();
+	tsc_ns_mult = ((uint64_t) NS_PER_SEC << 32) / tsc_hz;
 }
 
 /* OS가 부팅된 이후로 경과한 timer tick의 수를 반환한다. */
@@ -105,6 +211,28 @@ void timer_sleep(int64_t ticks)
 		thread_sleep(start + ticks); // busy waiting 대신 스레드를 블록 상태로 전환하여 CPU 낭비 방지
 }
 
+/* Returns the number of nanoseconds since the OS booted.  Uses
+   the TSC once timer_calibrate() has run, and timer ticks before
+   that. */
+uint64_t
+timer_now_ns (void) {
+	uint64_t cycles;
+
+	if (tsc_ns_mult == 0)
+		return timer_ticks () * NS_PER_TICK;
+
+	cycles = rdtsc () - tsc_base;
+	return tsc_base_ns
+		+ (uint64_t) (((unsigned __int128) cycles * tsc_ns_mult) >> 32);
+}
+
+/* Converts a span of CYCLES TSC cycles into nanoseconds.
+   Returns 0 until timer_calibrate() has run. */
+uint64_t
+timer_tsc_to_ns (uint64_t cycles) {
+	return ((unsigned __int128) cycles * tsc_ns_mult) >> 32;
+}
+
 /* Suspends execution for approximately MS milliseconds. */
 void
 timer_msleep (int64_t ms) {
@@ -127,15 +255,397 @@ timer_nsleep (int64_t ns) {
 void
 timer_print_stats (void) {
 	printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+	if (timer_tickless)
+		printf ("Timer: tick stopped %lld times (%lld on the RTC), "
+				"%lld interrupts skipped\n",
+				tickless_cnt, long_stop_cnt, skipped_ticks);
+	printf ("Timer: %lld sub-tick delays blocked, %lld spun\n",
+			hrtimer_sleep_cnt, tsc_spin_cnt);
+}
+
+/* Programs 8254 counter 0 to interrupt TIMER_FREQ times per
+   second. */
+static void
+pit_set_periodic (void) {
+	/* 8254 input frequency divided by TIMER_FREQ, rounded to
+	   nearest. */
+	uint16_t count = PIT_TICK_COUNT;
+
+	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
+	outb (0x40, count & 0xff);
+	outb (0x40, count >> 8);
+}
+
+/* Programs 8254 counter 0 to raise a single interrupt after
+   COUNT input clocks. */
+static void
+pit_set_oneshot (uint16_t count) {
+	outb (0x43, 0x30);    /* CW: counter 0, LSB then MSB, mode 0, binary. */
+	outb (0x40, count & 0xff);
+	outb (0x40, count >> 8);
+}
+
+/* Halts 8254 counter 0.  In mode 0 the counter waits for a new
+   count after the control word, so it raises no interrupt until
+   pit_set_oneshot(). */
+static void
+pit_halt (void) {
+	outb (0x43, 0x30);    /* CW: counter 0, LSB then MSB, mode 0, binary. */
+}
+
+/* Returns the current count of 8254 counter 0. */
+static uint16_t
+pit_read_count (void) {
+	uint16_t count;
+
+	outb (0x43, 0x00);    /* Counter latch command for counter 0. */
+	count = inb (0x40);
+	count |= inb (0x40) << 8;
+	return count;
+}
+
+/// @brief idle 스레드가 hlt 직전에 호출. 다음 타이머 만료까지 주기 인터럽트를 멈추고
+///        8254를 one-shot 모드로 설정 (-tickless 옵션일 때만)
+///
+/// 8254 한 번으로 덮을 수 없는 긴 정지는 8254를 멈추고 RTC의 느린 주기 인터럽트로 깨어남.
+/// hrtimer가 대기 중이면 RTC가 이미 빠른 주기로 돌고 있으므로 8254 한계까지만 멈춤.
+void timer_idle_stop_tick (void)
+{
+	int64_t delta;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (!timer_tickless || tick_stopped)
+		return;
+
+	// 휠의 슬롯을 한 바퀴까지만 보면 되므로 TICKLESS_LONG_MAX_TICKS까지 찾아봄
+	delta = timer_next_expiry (ticks + TICKLESS_LONG_MAX_TICKS) - ticks;
+	if (delta <= 1)
+		return;
+
+	if (delta > TICKLESS_MAX_TICKS && tsc_ns_mult != 0
+			&& list_empty (&hrtimers)) {
+		/* The stop starts from the last tick boundary, which the
+		   periodic count tells us how far back lies.  The RTC must
+		   fire before the deadline, which is at least DELTA - 1
+		   ticks away. */
+		uint64_t in_tick = (uint64_t) (PIT_TICK_COUNT - pit_read_count ())
+			* NS_PER_SEC / PIT_HZ;
+
+		if (rtc_wakeup_start ((delta - 1) * NS_PER_TICK) != 0) {
+			long_base_ns = timer_now_ns () - in_tick;
+			pit_halt ();
+			tick_stopped = true;
+			tick_long = true;
+			tickless_cnt++;
+			long_stop_cnt++;
+			return;
+		}
+	}
+
+	// 8254 한 번으로 멈출 수 있는 틱 수는 16비트 카운터 한계(TICKLESS_MAX_TICKS)까지
+	if (delta > TICKLESS_MAX_TICKS)
+		delta = TICKLESS_MAX_TICKS;
+	pit_set_oneshot (delta * PIT_TICK_COUNT);
+	tick_stopped = true;
+	stopped_ticks = delta;
+	tickless_cnt++;
+}
+
+/// @brief 외부 인터럽트 진입 시 호출. 틱이 멈춰 있었다면 지나간 틱 경계만큼 ticks를 따라잡음
+///
+/// one-shot이 끝났다면 8254를 주기 모드로 되돌리고, 다른 장치 때문에 일찍 깼다면
+/// 다음 틱 경계까지만 다시 one-shot을 걸어 틱의 위상을 그대로 유지한다.
+/// RTC로 깨어나는 긴 정지였다면 지나간 틱을 TSC로 세고 같은 방식으로 다음 경계에 one-shot을 건다.
+/// 모드 0에서 OUT이 low인 채로 모드 2를 쓰면 OUT이 올라가며 가짜 IRQ0가
+/// 생기므로, 주기 모드 복귀는 항상 OUT이 high일 때만 한다.
+void timer_idle_restart_tick (void)
+{
+	uint8_t status;
+	uint16_t remaining;
+	int64_t elapsed;
+
+	ASSERT (intr_context ());
+
+	if (!tick_stopped)
+		return;
+
+	if (tick_long) {
+		/* Count the tick boundaries crossed since the stop from
+		   the TSC, then re-arm the 8254 for the next boundary so
+		   that the tick keeps its phase. */
+		uint64_t ns = timer_now_ns () - long_base_ns;
+		uint64_t count = DIV_ROUND_UP ((NS_PER_TICK - ns % NS_PER_TICK) * PIT_HZ,
+				NS_PER_SEC);
+
+		rtc_wakeup_stop ();
+		tick_long = false;
+		stopped_ticks = 1;
+		pit_set_oneshot (count < PIT_TICK_COUNT ? count : PIT_TICK_COUNT);
+		tick_catch_up (ns / NS_PER_TICK);
+		return;
+	}
+
+	/* Read-back command: latch status and count of counter 0. */
+	outb (0x43, 0xc2);
+	status = inb (0x40);
+	remaining = inb (0x40);
+	remaining |= inb (0x40) << 8;
+
+	if (status & 0x80) {
+		/* OUT is high, so the one-shot count already ran out and
+		   its interrupt is either this one or still pending.
+		   timer_interrupt() accounts for that last tick. */
+		elapsed = stopped_ticks - 1;
+		tick_stopped = false;
+		pit_set_periodic ();
+	} else {
+		/* Woken early by another device.  Tick boundaries lie
+		   every PIT_TICK_COUNT clocks before the one-shot expiry;
+		   count the ones already crossed and re-arm for the next. */
+		int64_t left = DIV_ROUND_UP (remaining, PIT_TICK_COUNT);
+		if (left == 0)
+			left = 1;
+		elapsed = stopped_ticks - left;
+		stopped_ticks = 1;
+		pit_set_oneshot (remaining - (left - 1) * PIT_TICK_COUNT);
+	}
+
+	tick_catch_up (elapsed);
+}
+
+/// @brief 틱이 멈춰 있던 동안 지나간 ELAPSED개의 틱 경계를 ticks와 스케줄러, 타이머 휠에 반영
+static void tick_catch_up (int64_t elapsed)
+{
+	skipped_ticks += elapsed;
+	while (elapsed-- > 0) {
+		ticks++;
+		thread_tick ();
+	}
+	timer_wheel_advance (ticks);
 }
 
+/// @brief 타이머를 EXPIRES 틱에 FUNC(AUX)가 호출되도록 등록 (O(1))
+/// @param t 등록할 타이머, 이미 대기 중이면 안 됨
+/// @param expires 만료될 절대 틱, 이미 지났다면 다음 틱에 호출
+/// @param func 타이머 인터럽트 안에서 호출될 콜백
+/// @param aux 콜백 인자
+void timer_add (struct timer *t, int64_t expires, timer_func *func, void *aux)
+{
+	enum intr_level old_level;
+
+	ASSERT (t != NULL);
+	ASSERT (func != NULL);
+
+	old_level = intr_disable ();
+	ASSERT (!t->pending);
+
+	// 이미 지난 시각이면 다음 틱 슬롯에 넣어 바로 처리되도록 함
+	if (expires <= wheel_ticks)
+		expires = wheel_ticks + 1;
+
+	t->expires = expires;
+	t->func = func;
+	t->aux = aux;
+	t->pending = true;
+	list_push_back (&wheel[expires & TIMER_WHEEL_MASK], &t->elem);
+	timer_cnt++;
+
+	intr_set_level (old_level);
+}
+
+/// @brief 대기 중인 타이머를 취소
+/// @param t 취소할 타이머
+/// @return 타이머가 대기 중이어서 취소했다면 true, 이미 만료(또는 미등록)였다면 false
+bool timer_cancel (struct timer *t)
+{
+	enum intr_level old_level;
+	bool was_pending;
+
+	ASSERT (t != NULL);
+
+	old_level = intr_disable ();
+	was_pending = t->pending;
+	if (was_pending) {
+		list_remove (&t->elem);
+		t->pending = false;
+		timer_cnt--;
+	}
+	intr_set_level (old_level);
+
+	return was_pending;
+}
+
+/// @brief 타이머가 아직 만료되지 않고 대기 중인지 반환
+bool timer_pending (const struct timer *t)
+{
+	return t->pending;
+}
+
+/// @brief 고해상도 타이머를 EXPIRES(ns)에 FUNC(AUX)가 호출되도록 등록
+/// @param t 등록할 타이머, 이미 대기 중이면 안 됨
+/// @param expires timer_now_ns() 기준 만료 시각, 이미 지났다면 다음 RTC 인터럽트에 호출
+/// @param func 인터럽트 안에서 호출될 콜백
+/// @param aux 콜백 인자
+void hrtimer_add (struct hrtimer *t, uint64_t expires, timer_func *func,
+		void *aux)
+{
+	enum intr_level old_level;
+
+	ASSERT (t != NULL);
+	ASSERT (func != NULL);
+
+	old_level = intr_disable ();
+	ASSERT (!t->pending);
+
+	t->expires = expires;
+	t->func = func;
+	t->aux = aux;
+	t->pending = true;
+
+	// 첫 타이머가 등록될 때만 RTC 주기 인터럽트를 켬
+	if (list_empty (&hrtimers))
+		rtc_periodic_start ();
+	list_insert_ordered (&hrtimers, &t->elem, hrtimer_less, NULL);
+
+	intr_set_level (old_level);
+}
+
+/// @brief 대기 중인 고해상도 타이머를 취소
+/// @param t 취소할 타이머
+/// @return 타이머가 대기 중이어서 취소했다면 true, 이미 만료(또는 미등록)였다면 false
+bool hrtimer_cancel (struct hrtimer *t)
+{
+	enum intr_level old_level;
+	bool was_pending;
+
+	ASSERT (t != NULL);
+
+	old_level = intr_disable ();
+	was_pending = t->pending;
+	if (was_pending) {
+		list_remove (&t->elem);
+		t->pending = false;
+		if (list_empty (&hrtimers))
+			rtc_periodic_stop ();
+	}
+	intr_set_level (old_level);
+
+	return was_pending;
+}
+
+/// @brief RTC 주기 인터럽트(와 타이머 인터럽트)에서 호출되어 만료된 고해상도 타이머를 처리
+void hrtimer_interrupt (void)
+{
+	uint64_t now;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	now = timer_now_ns ();
+	while (!list_empty (&hrtimers)) {
+		struct hrtimer *t = list_entry (list_front (&hrtimers),
+				struct hrtimer, elem);
+
+		if (t->expires > now)
+			break;
+		list_pop_front (&hrtimers);
+		t->pending = false;
+		t->func (t->aux);
+	}
+
+	// 남은 타이머가 없으면 RTC 인터럽트를 꺼서 평소에는 비용이 없도록 함
+	if (list_empty (&hrtimers))
+		rtc_periodic_stop ();
+}
+
+/// @brief hrtimers 리스트를 만료 시각 오름차순으로 유지하기 위한 비교 함수
+static bool hrtimer_less (const struct list_elem *a, const struct list_elem *b,
+		void *aux UNUSED)
+{
+	return list_entry (a, struct hrtimer, elem)->expires
+		< list_entry (b, struct hrtimer, elem)->expires;
+}
+
+/// @brief LIMIT 틱까지 중 가장 먼저 만료될 타이머의 틱 (idle 진입 시에만 사용)
+/// @param limit 찾아볼 최대 틱
+/// @return 가장 이른 만료 틱, LIMIT 전에 만료될 타이머가 없으면 LIMIT
+static int64_t timer_next_expiry (int64_t limit)
+{
+	int64_t when;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (timer_cnt == 0)
+		return limit;
+
+	// limit까지의 슬롯만 보면 되므로 최대 TICKLESS_LONG_MAX_TICKS개(휠 한 바퀴)의 슬롯만 확인
+	for (when = wheel_ticks + 1; when < limit; when++) {
+		struct list *slot = &wheel[when & TIMER_WHEEL_MASK];
+		struct list_elem *e;
+
+		for (e = list_begin (slot); e != list_end (slot); e = list_next (e))
+			if (list_entry (e, struct timer, elem)->expires <= when)
+				return when;
+	}
+	return limit;
+}
+
+/// @brief 타이머 휠을 NOW 틱까지 진행시키며 만료된 타이머의 콜백을 호출
+/// @param now 현재 틱
+static void timer_wheel_advance (int64_t now)
+{
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	while (wheel_ticks < now) {
+		struct list *slot;
+		struct list expired;
+		struct list_elem *e;
+
+		wheel_ticks++;
+
+		// 대기 중인 타이머가 없거나 이번 슬롯이 비었다면 바로 반환 (O(1))
+		if (timer_cnt == 0) {
+			wheel_ticks = now;
+			break;
+		}
+		slot = &wheel[wheel_ticks & TIMER_WHEEL_MASK];
+		if (list_empty (slot))
+			continue;
+
+		// 만료된 타이머를 먼저 떼어낸 뒤 콜백을 호출해야
+		// 콜백 안에서 타이머를 추가, 취소해도 슬롯 순회가 깨지지 않음
+		list_init (&expired);
+		for (e = list_begin (slot); e != list_end (slot); ) {
+			struct timer *t = list_entry (e, struct timer, elem);
+
+			if (t->expires <= wheel_ticks) {
+				e = list_remove (e);
+				list_push_back (&expired, &t->elem);
+			}
+			else
+				e = list_next (e);
+		}
+
+		while (!list_empty (&expired)) {
+			struct timer *t = list_entry (list_pop_front (&expired),
+					struct timer, elem);
+			t->pending = false;
+			timer_cnt--;
+			t->func (t->aux);
+		}
+	}
+}
+
 /* Timer interrupt handler. */
 static void timer_interrupt (struct intr_frame *args UNUSED)
 {
 	ticks++;
 	thread_tick ();
 
-	thread_awake(ticks);
+	timer_wheel_advance (ticks);
+
+	if (!list_empty (&hrtimers))
+		hrtimer_interrupt ();
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -186,11 +696,36 @@ real_time_sleep (int64_t num, int32_t denom) {
 		   timer_sleep() because it will yield the CPU to other
 		   processes. */
 		timer_sleep (ticks);
-	} else {
-		/* Otherwise, use a busy-wait loop for more accurate
-		   sub-tick timing.  We scale the numerator and denominator
-		   down by 1000 to avoid the possibility of overflow. */
+	} else if (tsc_ns_mult == 0) {
+		/* The TSC is not calibrated yet, so use a busy-wait loop
+		   for sub-tick timing.  We scale the numerator and
+		   denominator down by 1000 to avoid the possibility of
+		   overflow. */
 		ASSERT (denom % 1000 == 0);
 		busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
+	} else {
+		/* Sub-tick delay.  Block on an hrtimer so that other
+		   threads get the CPU, unless the delay is shorter than
+		   HRTIMER_SPIN_NS.  Either way, finish by spinning on the
+		   TSC until the deadline, which covers the last RTC period
+		   and also absorbs an early return from
+		   thread_sleep_ns(). */
+		int64_t ns;
+		uint64_t deadline;
+
+		ASSERT (NS_PER_SEC % denom == 0);
+		ns = num * (NS_PER_SEC / denom);
+		if (ns <= 0)
+			return;
+		deadline = timer_now_ns () + ns;
+
+		if (ns >= HRTIMER_SPIN_NS) {
+			hrtimer_sleep_cnt++;
+			thread_sleep_ns (deadline - RTC_PERIOD_NS);
+		} else
+			tsc_spin_cnt++;
+
+		while (timer_now_ns () < deadline)
+			barrier ();
 	}
 }
@@ -0,0 +1,56 @@
+#ifndef ATOMIC_H
+#define ATOMIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Atomic operations on 64-bit integers.
+
+   Each is a single instruction, which an interrupt cannot split, so
+   a counter or id shared with interrupt handlers can be updated
+   without intr_disable() or a struct lock.  The "lock" prefix also
+   makes them atomic with respect to other CPUs, and the "memory"
+   clobber keeps the compiler from moving other memory accesses
+   across them. */
+
+/* Returns *P and atomically adds V to it. */
+__attribute__((always_inline))
+static __inline int64_t atomic_fetch_add(volatile int64_t *p, int64_t v) {
+	__asm __volatile("lock xaddq %0, %1" : "+r" (v), "+m" (*p) : : "memory");
+	return v;
+}
+
+/* Atomically increments *P. */
+__attribute__((always_inline))
+static __inline void atomic_inc(volatile int64_t *p) {
+	__asm __volatile("lock incq %0" : "+m" (*p) : : "memory");
+}
+
+/* If *P equals EXPECTED, atomically sets it to DESIRED and returns
+   true.  Otherwise leaves it unchanged and returns false. */
+__attribute__((always_inline))
+static __inline bool atomic_cmpxchg(volatile int64_t *p, int64_t expected,
+		int64_t desired) {
+	int64_t prev;
+	__asm __volatile("lock cmpxchgq %2, %1"
+			: "=a" (prev), "+m" (*p)
+			: "r" (desired), "0" (expected)
+			: "memory");
+	return prev == expected;
+}
+
+/* Returns *P.  Aligned 64-bit loads are atomic on x86-64. */
+__attribute__((always_inline))
+static __inline int64_t atomic_load(const volatile int64_t *p) {
+	int64_t v;
+	__asm __volatile("movq %1, %0" : "=r" (v) : "m" (*p) : "memory");
+	return v;
+}
+
+/* Sets *P to V.  Aligned 64-bit stores are atomic on x86-64. */
+__attribute__((always_inline))
+static __inline void atomic_store(volatile int64_t *p, int64_t v) {
+	__asm __volatile("movq %1, %0" : "=m" (*p) : "r" (v) : "memory");
+}
+
+#endif /* atomic.h */
@@ -0,0 +1,15 @@
+#ifndef DEVICES_RTC_H
+#define DEVICES_RTC_H
+
+#include <stdint.h>
+
+/* Frequency of the RTC periodic interrupt, in Hz. */
+#define RTC_PERIODIC_FREQ 8192
+
+void rtc_init (void);
+void rtc_periodic_start (void);
+void rtc_periodic_stop (void);
+uint64_t rtc_wakeup_start (uint64_t max_ns);
+void rtc_wakeup_stop (void);
+
+#endif /* devices/rtc.h */
@@ -1,23 +1,68 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* If true, stop the periodic tick while idle.
+   Controlled by kernel command-line option "-tickless". */
+extern bool timer_tickless;
+
+/* Kernel timer callback.  Runs in the timer interrupt handler,
+   with interrupts off, so it must not sleep. */
+typedef void timer_func (void *aux);
+
+/* A one-shot kernel timer.  Embed one in whatever structure
+   needs a timeout and arm it with timer_add(). */
+struct timer {
+	int64_t expires;            /* Absolute tick at which to fire. */
+	timer_func *func;           /* Callback. */
+	void *aux;                  /* Callback argument. */
+	bool pending;               /* Armed and not yet fired? */
+	struct list_elem elem;      /* Timer wheel slot element. */
+};
+
+/* A one-shot high-resolution timer, with a deadline on the
+   timer_now_ns() clock instead of in ticks.  Expiry is driven by
+   the RTC periodic interrupt, so it fires within about
+   1/RTC_PERIODIC_FREQ seconds of its deadline. */
+struct hrtimer {
+	uint64_t expires;           /* Absolute deadline in ns. */
+	timer_func *func;           /* Callback. */
+	void *aux;                  /* Callback argument. */
+	bool pending;               /* Armed and not yet fired? */
+	struct list_elem elem;      /* Pending hrtimer list element. */
+};
+
 void timer_init (void);
 void timer_calibrate (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
+uint64_t timer_now_ns (void);
+uint64_t timer_tsc_to_ns (uint64_t cycles);
 
 void timer_sleep (int64_t ticks);
 void timer_msleep (int64_t milliseconds);
 void timer_usleep (int64_t microseconds);
 void timer_nsleep (int64_t nanoseconds);
 
+void timer_add (struct timer *, int64_t expires, timer_func *, void *aux);
+bool timer_cancel (struct timer *);
+bool timer_pending (const struct timer *);
+
+void hrtimer_add (struct hrtimer *, uint64_t expires, timer_func *, void *aux);
+bool hrtimer_cancel (struct hrtimer *);
+void hrtimer_interrupt (void);
+
+void timer_idle_stop_tick (void);
+void timer_idle_restart_tick (void);
+
 void timer_print_stats (void);
 
 #endif /* devices/timer.h */
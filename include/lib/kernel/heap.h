@@ -0,0 +1,68 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Priority queue (max-heap).
+ *
+ * This is a pairing heap: a heap-ordered multiway tree whose
+ * root is the greatest element.  Insertion and increasing an
+ * element's key are O(1); removing the greatest element, or any
+ * other element, is O(log n) amortized.
+ *
+ * Like lists and hash tables, heaps do not use dynamic
+ * allocation.  Each structure that can potentially be in a heap
+ * must embed a struct heap_elem member, and the heap_entry macro
+ * converts a struct heap_elem back to the structure that
+ * contains it.  Refer to lib/kernel/list.h for a detailed
+ * explanation of the technique.
+ *
+ * An element's key must not change while it is in a heap, except
+ * by increasing it and then calling heap_increase().  To make any
+ * other change, heap_remove() the element, change it, and
+ * heap_push() it back. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem {
+	struct heap_elem *child;    /* First child, or NULL. */
+	struct heap_elem *next;     /* Next sibling, or NULL. */
+	struct heap_elem *prev;     /* Previous sibling, or parent if first child. */
+};
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+ * the structure that HEAP_ELEM is embedded inside.  Supply the
+ * name of the outer structure STRUCT and the member name MEMBER
+ * of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)           \
+	((STRUCT *) ((uint8_t *) &(HEAP_ELEM)->child        \
+		- offsetof (STRUCT, MEMBER.child)))
+
+/* Compares the value of two heap elements A and B, given
+ * auxiliary data AUX.  Returns true if A is less than B, or
+ * false if A is greater than or equal to B. */
+typedef bool heap_less_func (const struct heap_elem *a,
+		const struct heap_elem *b,
+		void *aux);
+
+/* Heap. */
+struct heap {
+	struct heap_elem *root;     /* Greatest element, or NULL if empty. */
+	size_t elem_cnt;            /* Number of elements. */
+	heap_less_func *less;       /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+
+void heap_push (struct heap *, struct heap_elem *);
+struct heap_elem *heap_pop (struct heap *);
+void heap_remove (struct heap *, struct heap_elem *);
+void heap_increase (struct heap *, struct heap_elem *);
+
+struct heap_elem *heap_top (const struct heap *);
+size_t heap_size (const struct heap *);
+bool heap_empty (const struct heap *);
+
+#endif /* lib/kernel/heap.h */
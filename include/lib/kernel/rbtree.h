@@ -0,0 +1,67 @@
+#ifndef __LIB_KERNEL_RBTREE_H
+#define __LIB_KERNEL_RBTREE_H
+
+/* Red-black tree.
+ *
+ * A balanced binary search tree ordered by a caller-supplied
+ * comparison function.  Insertion and removal are O(log n).  The
+ * tree keeps a pointer to its least node, so rb_first() is O(1).
+ * Nodes that compare equal are kept in insertion order.
+ *
+ * Like lists and heaps, red-black trees do not use dynamic
+ * allocation.  Each structure that can potentially be in a tree
+ * must embed a struct rb_node member, and the rb_entry macro
+ * converts a struct rb_node back to the structure that contains
+ * it.  Refer to lib/kernel/list.h for a detailed explanation of
+ * the technique.
+ *
+ * A node's key must not change while it is in a tree.  To change
+ * it, rb_remove() the node, change it, and rb_insert() it back. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Red-black tree node. */
+struct rb_node {
+	struct rb_node *parent;     /* Parent, or NULL for the root. */
+	struct rb_node *left;       /* Left child, or NULL. */
+	struct rb_node *right;      /* Right child, or NULL. */
+	bool red;                   /* Red or black? */
+};
+
+/* Converts pointer to tree node RB_NODE into a pointer to the
+ * structure that RB_NODE is embedded inside.  Supply the name of
+ * the outer structure STRUCT and the member name MEMBER of the
+ * tree node. */
+#define rb_entry(RB_NODE, STRUCT, MEMBER)               \
+	((STRUCT *) ((uint8_t *) &(RB_NODE)->parent         \
+		- offsetof (STRUCT, MEMBER.parent)))
+
+/* Compares the value of two tree nodes A and B, given auxiliary
+ * data AUX.  Returns true if A is less than B, or false if A is
+ * greater than or equal to B. */
+typedef bool rb_less_func (const struct rb_node *a,
+		const struct rb_node *b,
+		void *aux);
+
+/* Red-black tree. */
+struct rbtree {
+	struct rb_node *root;       /* Root, or NULL if empty. */
+	struct rb_node *first;      /* Least node, or NULL if empty. */
+	size_t node_cnt;            /* Number of nodes. */
+	rb_less_func *less;         /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+void rb_init (struct rbtree *, rb_less_func *, void *aux);
+
+void rb_insert (struct rbtree *, struct rb_node *);
+void rb_remove (struct rbtree *, struct rb_node *);
+
+struct rb_node *rb_first (const struct rbtree *);
+struct rb_node *rb_next (const struct rb_node *);
+size_t rb_size (const struct rbtree *);
+bool rb_empty (const struct rbtree *);
+
+#endif /* lib/kernel/rbtree.h */
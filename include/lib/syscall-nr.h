@@ -36,6 +36,12 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Scheduling. */
+	SYS_GETNICE,                /* Obtain the caller's nice value. */
+	SYS_SETNICE,                /* Change the caller's nice value. */
+	SYS_GETPRIORITY,            /* Obtain the caller's priority. */
+	SYS_SETPRIORITY,            /* Change the caller's priority. */
 };
 
 #endif /* lib/syscall-nr.h */
@@ -21,7 +21,7 @@ typedef int off_t;
 #define EXIT_SUCCESS 0          /* Successful execution. */
 #define EXIT_FAILURE 1          /* Unsuccessful execution. */
 
-extern struct lock filesys_lock; // 파일 읽기 쓰기 lock
+extern struct rwlock filesys_lock; // 파일 시스템 rwlock (조회는 읽기, 변경은 쓰기)
 /* Projects 2 and later. */
 void halt_(void);
 void exit_(int status);
@@ -37,6 +37,10 @@ int write_(int fd, const void *buffer, unsigned size);
 void seek_(int fd, unsigned position);
 unsigned tell_(int fd);
 void close_(int fd);
+int getnice_(void);
+void setnice_(int nice);
+int getpriority_(void);
+void setpriority_(int priority);
 // struct page * check_address(void *address);
 struct page * check_address(void *addr);
 void check_valid_buffer(void* buffer, unsigned size, void* rsp, bool to_write);
@@ -55,6 +59,12 @@ bool isdir (int fd);
 int inumber (int fd);
 int symlink (const char* target, const char* linkpath);
 
+/* Scheduling. */
+int getnice (void);
+void setnice (int nice);
+int getpriority (void);
+void setpriority (int priority);
+
 static inline void* get_phys_addr (void *user_addr) {
 	void* pa;
 	asm volatile ("movq %0, %%rax" ::"r"(user_addr));
@@ -0,0 +1,49 @@
+#ifndef THREADS_FIXED_POINT_H
+#define THREADS_FIXED_POINT_H
+
+#include <stdint.h>
+
+/* 17.14 fixed-point arithmetic for the 4.4BSD scheduler.
+
+   A fixed-point number is stored in an int whose low 14 bits are
+   the fraction, so the representable range is about +/-131,071.
+   In the names below, X and Y are fixed-point numbers and N is
+   an integer.  Products and quotients of two fixed-point numbers
+   go through int64_t to avoid overflowing the intermediate
+   value. */
+
+typedef int fixed_t;
+
+#define FP_SHIFT 14                     /* # of fraction bits. */
+#define FP_F (1 << FP_SHIFT)            /* 1.0 in fixed point. */
+
+/* Converts integer N to fixed point. */
+static inline fixed_t int_to_fp (int n) { return n * FP_F; }
+
+/* Converts X to integer, rounding toward zero. */
+static inline int fp_to_int (fixed_t x) { return x / FP_F; }
+
+/* Converts X to integer, rounding to nearest. */
+static inline int
+fp_to_int_round (fixed_t x) {
+	return x >= 0 ? (x + FP_F / 2) / FP_F : (x - FP_F / 2) / FP_F;
+}
+
+static inline fixed_t add_fp (fixed_t x, fixed_t y) { return x + y; }
+static inline fixed_t sub_fp (fixed_t x, fixed_t y) { return x - y; }
+static inline fixed_t add_mixed (fixed_t x, int n) { return x + n * FP_F; }
+static inline fixed_t sub_mixed (fixed_t x, int n) { return x - n * FP_F; }
+static inline fixed_t mult_mixed (fixed_t x, int n) { return x * n; }
+static inline fixed_t div_mixed (fixed_t x, int n) { return x / n; }
+
+static inline fixed_t
+mult_fp (fixed_t x, fixed_t y) {
+	return ((int64_t) x) * y / FP_F;
+}
+
+static inline fixed_t
+div_fp (fixed_t x, fixed_t y) {
+	return ((int64_t) x) * FP_F / y;
+}
+
+#endif /* threads/fixed_point.h */
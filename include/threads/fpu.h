@@ -0,0 +1,21 @@
+#ifndef THREADS_FPU_H
+#define THREADS_FPU_H
+
+#include <stdbool.h>
+#include "threads/interrupt.h"
+
+struct thread;
+
+void fpu_init (void);
+void fpu_switch (struct thread *next);
+bool fpu_restore_current (void);
+bool fpu_fork (struct thread *child, struct thread *parent);
+void fpu_release (struct thread *);
+void fpu_print_stats (void);
+
+/* Brackets kernel code that uses FPU or vector instructions.
+   Interrupts stay off in between, so such code must not sleep. */
+enum intr_level kernel_fpu_begin (void);
+void kernel_fpu_end (enum intr_level);
+
+#endif /* threads/fpu.h */
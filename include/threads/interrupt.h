@@ -15,6 +15,9 @@ enum intr_level intr_set_level (enum intr_level);
 enum intr_level intr_enable (void);
 enum intr_level intr_disable (void);
 
+extern bool intr_latency;
+void intr_print_latency (void);
+
 /* Interrupt stack frame. */
 struct gp_registers {
 	uint64_t r15;
@@ -0,0 +1,56 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <list.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "threads/synch.h"
+
+/* Slab object caches.
+
+   A kmem_cache hands out objects of one fixed size.  It carves
+   pages from the kernel pool ("slabs") into as many objects as
+   fit, so objects are not rounded up to a power of 2 the way
+   malloc() rounds them, and each cache has its own lock instead
+   of sharing malloc()'s per-size-class locks with every other
+   user of that size.
+
+   If the cache has a constructor, it runs once on each object
+   when its slab is created, not on every allocation.  Callers
+   must therefore return objects to the cache in their constructed
+   state. */
+
+/* Puts a newly created object OBJ into its constructed state. */
+typedef void kmem_ctor (void *obj);
+
+/* An object cache. */
+struct kmem_cache {
+	char name[24];              /* Name, for statistics. */
+	size_t obj_size;            /* Object size, rounded up to ALIGN. */
+	size_t align;               /* Object alignment. */
+	size_t objs_per_slab;       /* Objects in one slab. */
+	size_t obj_ofs;             /* Offset of the first object in a slab. */
+	kmem_ctor *ctor;            /* Constructor, or NULL. */
+
+	struct lock lock;           /* Protects everything below. */
+	struct list partial;        /* Slabs with some objects in use. */
+	struct list full;           /* Slabs with every object in use. */
+	struct list empty;          /* Slabs with no object in use. */
+	size_t empty_cnt;           /* Length of EMPTY. */
+	size_t slab_cnt;            /* Slabs in all three lists. */
+	size_t in_use;              /* Objects handed out. */
+	int64_t allocs;             /* # of kmem_cache_alloc() calls. */
+	int64_t frees;              /* # of kmem_cache_free() calls. */
+	int64_t slabs_created;      /* # of slabs taken from palloc. */
+
+	struct list_elem elem;      /* Element in the list of all caches. */
+};
+
+void slab_init (void);
+void kmem_cache_init (struct kmem_cache *, const char *name, size_t size,
+		size_t align, kmem_ctor *);
+void *kmem_cache_alloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *);
+void kmem_cache_print_stats (void);
+
+#endif /* threads/slab.h */
@@ -0,0 +1,29 @@
+#ifndef THREADS_SWITCH_H
+#define THREADS_SWITCH_H
+
+#include <stdint.h>
+
+/* switch_to()'s stack frame.  The callee-saved registers are all
+   that a kernel-to-kernel switch has to preserve, because
+   switch_to() is an ordinary function call as far as the compiler
+   is concerned. */
+struct switch_frame {
+	uint64_t r15;
+	uint64_t r14;
+	uint64_t r13;
+	uint64_t r12;
+	uint64_t rbp;
+	uint64_t rbx;
+	void (*rip) (void);         /* Return address. */
+};
+
+/* Saves the current stack pointer in *CUR_SP and switches to the
+   stack NEXT_SP, which must have been saved by switch_to() or set
+   up as a switch_frame returning to switch_entry(). */
+void switch_to (uint64_t *cur_sp, uint64_t next_sp);
+
+/* Entry point of a stack that has never run.  Calls R12 with R13
+   and R14 as its two arguments. */
+void switch_entry (void);
+
+#endif /* threads/switch.h */
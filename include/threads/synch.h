@@ -1,13 +1,17 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
+
+struct thread;
 
 /* A counting semaphore. */
 struct semaphore {
 	unsigned value;             /* Current value. */
-	struct list waiters;        /* List of waiting threads. */
+	struct heap waiters;        /* Waiting threads, by priority. */
 };
 
 void sema_init (struct semaphore *, unsigned value);
@@ -15,11 +19,34 @@ void sema_down (struct semaphore *);
 bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
 void sema_self_test (void);
+void waiter_reprioritize (struct thread *, int old_priority);
+
+/* Contention statistics for one named lock or rwlock.  Only
+   collected while lock_profile is true (kernel option -lockprof).
+   Times are in nanoseconds. */
+struct lock_stat {
+	char name[24];              /* Name given to lock_set_name(). */
+	int64_t acquired;           /* # of acquisitions. */
+	int64_t contended;          /* # of acquisitions that had to wait. */
+	uint64_t wait_total;        /* Total time spent waiting. */
+	uint64_t wait_max;          /* Longest single wait. */
+	uint64_t hold_total;        /* Total time held. */
+	uint64_t hold_max;          /* Longest single hold. */
+	uint64_t held_since;        /* When the current holder got it. */
+};
+
+extern bool lock_profile;
+
+void lock_print_stats (void);
+const struct lock_stat *lock_stat_find (const char *name);
 
 /* Lock. */
 struct lock {
 	struct thread *holder;      /* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
+	int max_priority;           /* Highest priority among waiters. */
+	struct heap_elem elem;      /* Element in holder's held_locks. */
+	struct lock_stat *stat;     /* Profile slot, or NULL if unnamed. */
 };
 
 void lock_init (struct lock *);
@@ -27,18 +54,52 @@ void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
+void lock_set_name (struct lock *, const char *name);
+
+/* Reader-writer lock.  Either any number of readers or a single
+   writer may hold it.  It is writer-preferring: once a writer is
+   waiting, new readers queue behind it.  Waiters donate their
+   priority to the current holders, and the waiter with the higher
+   priority is woken first (a writer wins a tie). */
+struct rwlock {
+	struct thread *writer;      /* Thread holding it for writing. */
+	unsigned readers;           /* # of threads holding it for reading. */
+	struct list reader_list;    /* Their rwlock_holds, for donation. */
+	struct heap read_waiters;   /* Threads waiting to read. */
+	struct heap write_waiters;  /* Threads waiting to write. */
+	struct lock_stat *stat;     /* Profile slot, or NULL if unnamed. */
+};
+
+/* A thread's hold on an rwlock.  Each thread has RWLOCK_HOLD_MAX
+   of these, so it may hold that many rwlocks at once, in either
+   mode; acquiring one more panics, as does acquiring an rwlock it
+   already holds. */
+#define RWLOCK_HOLD_MAX 4
+struct rwlock_hold {
+	struct rwlock *rw;          /* Held rwlock, or NULL if unused. */
+	struct thread *thread;      /* Holding thread. */
+	struct list_elem elem;      /* Element in RW's reader_list. */
+	uint64_t since;             /* When it was acquired, in ns. */
+};
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+void rwlock_set_name (struct rwlock *, const char *name);
 
 /* Condition variable. */
 struct condition {
-	struct list waiters;        /* List of waiting threads. */
+	struct heap waiters;        /* Waiters' semaphores, by priority. */
 };
 
 void cond_init (struct condition *);
 void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
-bool cond_sema_priority(const struct list_elem *a, const struct list_elem *b, void *aux);
-bool thread_cmp_donate_priority (const struct list_elem *a, const struct list_elem *b, void *aux);
+bool cond_sema_priority(const struct heap_elem *a, const struct heap_elem *b, void *aux);
+bool lock_cmp_priority (const struct heap_elem *a, const struct heap_elem *b, void *aux);
 void multiple_donation(void);
 
 /* Optimization barrier.
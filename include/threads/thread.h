@@ -1,10 +1,14 @@
 #ifndef THREADS_THREAD_H
 #define THREADS_THREAD_H
 #include <debug.h>
+#include <hash.h>
 #include <list.h>
+#include <rbtree.h>
 #include <stdint.h>
 #include "threads/synch.h"
 #include "threads/interrupt.h"
+#include "devices/timer.h"
+#include "threads/fixed_point.h"
 #ifdef VM
 #include "vm/vm.h"
 #endif
@@ -26,8 +30,15 @@ typedef int tid_t;
 #define PRI_MIN 0                       /* Lowest priority. */
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
-#define FDPAGES 3
-#define FDCOUNT_LIMIT FDPAGES * (1 << 9) // 페이지 크기 4kb / 파일 포인터 8바이트 = 512
+
+/* Thread niceness (4.4BSD scheduler). */
+#define NICE_MIN -20                    /* Nicest to other threads. */
+#define NICE_DEFAULT 0                  /* Default niceness. */
+#define NICE_MAX 20                     /* Least nice. */
+
+/* File descriptor table (userprog/process.c). */
+#define FD_INLINE 16                    /* Slots inside struct thread. */
+#define FDCOUNT_LIMIT 1536              /* Max # of fds per process. */
 
 /* A kernel thread or user process.
  *
@@ -96,12 +107,37 @@ struct thread {
 
 	int original_priority; 		  // 기부 받기 전 우선 순위
 	struct lock *waiting_lock;    // 대기 중인 락
-	struct list donations;        // 기부 받은 리스트들
-	struct list_elem donation_elem; // 기부자로 들어갈때 쓰는 연결점
+	struct rwlock *waiting_rw;    // 대기 중인 rwlock
+	struct heap held_locks;       // 보유 중인 락들, 대기자 최고 우선순위 순 (max-heap)
+	struct heap *wait_heap;       // 블록된 채 들어가 있는 대기자 힙 (세마포어, rwlock)
+	struct heap_elem wait_elem;   // 대기자 힙에 들어갈 때 쓰는 연결점
+	uint64_t wait_seq;            // 같은 우선순위끼리 FIFO를 지키기 위한 대기 순번
+	struct rwlock_hold rw_holds[RWLOCK_HOLD_MAX]; // 보유 중인 rwlock들 (읽기든 쓰기든)
+
+	/* 4.4BSD scheduler (thread.c). */
+	int nice;                           /* Niceness, NICE_MIN..NICE_MAX. */
+	fixed_t recent_cpu;                 /* Recent CPU usage. */
+	int64_t recent_cpu_epoch;           /* Epoch recent_cpu is decayed up to. */
+
+	/* CFS scheduler (thread.c). */
+	uint64_t vruntime;                  /* Weighted CPU time received. */
+	struct rb_node cfs_elem;            /* Element in the CFS timeline. */
+
+	/* EDF real-time class (thread.c).  Times are in timer ticks. */
+	int64_t edf_runtime;                /* Budget per period, or 0 if not EDF. */
+	int64_t edf_period;                 /* Replenishment period. */
+	int64_t edf_rel_deadline;           /* Deadline, relative to period start. */
+	int64_t edf_deadline;               /* Current absolute deadline. */
+	int64_t edf_budget;                 /* Budget left in this period. */
+	int64_t edf_bw;                     /* Admitted bandwidth, of EDF_BW_ONE. */
+	bool edf_queued;                    /* In the EDF ready heap? */
+	struct heap_elem edf_elem;          /* Element in the EDF ready heap. */
+	struct timer edf_timer;             /* Fires at the next period start. */
 
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem;              /* List element. */
-	int64_t wakeup_tick; 				// tick이 되면 깨어나야 함
+	struct timer sleep_timer; 			// 깨어나야 할 tick에 만료되는 타이머
+	void *fpu;                          /* FPU state area, or NULL (fpu.c). */
 
 	/* userprog thread field*/
 	struct file *runn_file;
@@ -111,16 +147,15 @@ struct thread {
 	uint64_t *pml4;                     /* Page map level 4 */
 	int exit_status;
 
-	int fd_index; 							// 파일 디스크립터 인덱스
-	// struct file *fd_table[FDCOUNT_LIMIT];	// 파일 디스크립터 테이블 -> 정적 할당
-	struct file **fd_table; // -> 동적 할당하기 위해 변경
- 
-	struct list child_list; // 자식 리스트
-	struct list_elem child_elem; // 부모의 child_list에 들어갈 때 사용
+	// 파일 디스크립터 테이블: fd_inline에서 시작해 가득 차면 malloc으로 두 배씩 늘림
+	struct file **fd_table;             // fd_inline 또는 malloc한 테이블
+	uint64_t *fd_map;                   // N번 비트가 켜져 있으면 fd N 사용 중
+	int fd_cap;                         // fd_table의 칸 수
+	struct file *fd_inline[FD_INLINE];  // 커널 스레드나 파일을 조금 여는 프로세스용
+	uint64_t fd_inline_map;
 
-	struct semaphore fork_sema; // fork 완료까지 대기
-	struct semaphore wait_sema; // wait 에서 대기
-	struct semaphore exit_sema; // 종료 시 부모를 꺠움
+	struct hash children;               // 아직 wait하지 않은 자식들의 종료 기록, tid로 찾음 (처음 자식을 만들 때 초기화)
+	struct child_status *exit_record;   // 부모와 공유하는 자신의 종료 기록, 없으면 NULL
 
 	struct intr_frame parent_if; 
 #endif
@@ -131,7 +166,7 @@ struct thread {
 #endif
 
 	/* Owned by thread.c. */
-	struct intr_frame tf;               /* Information for switching */
+	uint64_t ksp;                       /* Saved stack pointer (switch_to). */
 	unsigned magic;                     /* Detects stack overflow. */
 };
 
@@ -140,6 +175,11 @@ struct thread {
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use the completely fair scheduler, which shares the
+   CPU in proportion to a weight derived from each thread's
+   priority.  Controlled by kernel command-line option "-cfs". */
+extern bool thread_cfs;
+
 bool cmp_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
 
 void thread_init (void);
@@ -150,6 +190,9 @@ void thread_print_stats (void);
 
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
+#ifdef USERPROG
+tid_t thread_create_process (const char *name, int priority, thread_func *, void *);
+#endif
 
 void thread_block (void);
 void thread_unblock (struct thread *);
@@ -160,14 +203,21 @@ const char *thread_name (void);
 
 void thread_exit (void) NO_RETURN;
 void thread_yield (void);
+void thread_sleep (int64_t ticks);
+void thread_sleep_ns (uint64_t deadline);
 
 int thread_get_priority (void);
 void thread_set_priority (int);
+void thread_update_priority (struct thread *, int);
+
+bool thread_set_edf (int64_t runtime, int64_t period, int64_t deadline);
+void thread_clear_edf (void);
 
 int thread_get_nice (void);
 void thread_set_nice (int);
 int thread_get_recent_cpu (void);
 int thread_get_load_avg (void);
+unsigned thread_cfs_weight (int priority);
 bool cmp_priority(const struct list_elem *a, const struct list_elem *b, void *aux);
 void do_iret (struct intr_frame *tf);
 
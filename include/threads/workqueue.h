@@ -0,0 +1,54 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include "threads/synch.h"
+
+/* Deferred work ("bottom halves").
+
+   An interrupt handler that has more to do than acknowledging its
+   device can put a struct work on a workqueue with work_queue(),
+   which is safe to call with interrupts off, and return.  The
+   queue's worker thread later runs the work's function in thread
+   context with interrupts on, where it may sleep and take locks.
+
+   Queuing a work that is already pending does nothing, so a burst
+   of interrupts collapses into one run of the function, which
+   should then handle everything that has accumulated.  The worker
+   takes all pending works at once and runs them as one batch. */
+
+/* A function to run in a worker thread, given auxiliary data AUX. */
+typedef void work_func (void *aux);
+
+/* A unit of deferred work. */
+struct work {
+	struct list_elem elem;      /* Element in the workqueue's list. */
+	work_func *func;            /* Function to run. */
+	void *aux;                  /* Auxiliary data for FUNC. */
+	bool pending;               /* Queued and not yet started? */
+};
+
+/* A queue of works run in order by one worker thread. */
+struct workqueue {
+	const char *name;           /* Name, also used for the worker thread. */
+	struct list works;          /* Pending works. */
+	struct semaphore wakeup;    /* Upped when WORKS becomes nonempty. */
+	long long queued;           /* # of works queued. */
+	long long coalesced;        /* # of work_queue() calls on pending works. */
+	long long batches;          /* # of batches run. */
+	long long max_batch;        /* Largest batch run. */
+};
+
+/* Shared queues, served by a worker at PRI_MAX and one at
+   PRI_DEFAULT respectively. */
+extern struct workqueue wq_high;
+extern struct workqueue wq_default;
+
+void workqueue_init (void);
+void workqueue_create (struct workqueue *, const char *name, int priority);
+void work_init (struct work *, work_func *, void *aux);
+bool work_queue (struct workqueue *, struct work *);
+void workqueue_print_stats (void);
+
+#endif /* threads/workqueue.h */
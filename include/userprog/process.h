@@ -11,6 +11,20 @@ struct segment_info {
     size_t page_zero_bytes;
 };
 
+/* Exit status of a child process, shared by the child and its
+   parent.  It is freed when both have let go of it, so a child
+   that exits before its parent waits is destroyed at once instead
+   of lingering as a zombie thread. */
+struct child_status {
+	tid_t tid;                  /* Child's thread id. */
+	int exit_status;            /* Valid once exit_sema is upped. */
+	bool fork_ok;               /* Did __do_fork() succeed? */
+	int ref_cnt;                /* Parent and/or child still holding it. */
+	struct semaphore fork_sema; /* Upped when the child finishes forking. */
+	struct semaphore exit_sema; /* Upped when the child exits. */
+	struct hash_elem elem;      /* Element in the parent's children table. */
+};
+
 tid_t process_create_initd (const char *file_name);
 tid_t process_fork (const char *name, struct intr_frame *if_);
 int process_exec (void *f_name);
@@ -21,7 +35,7 @@ void argument_stack(char **argv, int argc, struct intr_frame *if_);
 struct file* process_get_file(int fd);
 int process_add_file(struct file *file);
 int process_close_file(int fd);
-struct thread *get_child_tid(tid_t child_tid);
+bool process_attach_child (struct thread *child);
 bool lazy_load_segment(struct page *page, void *aux);
 
 #endif /* userprog/process.h */
@@ -2,6 +2,7 @@
 #define VM_VM_H
 #include <stdbool.h>
 #include "threads/palloc.h"
+#include "threads/slab.h"
 #include "lib/kernel/hash.h"
 #include "vm/vm_type.h"
 
@@ -15,6 +16,7 @@
 struct page_operations;
 struct thread;
 extern struct list frame_table;
+extern struct kmem_cache segment_info_cache;
 
 #define VM_TYPE(type) ((type) & 7)
 
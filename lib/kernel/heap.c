@@ -0,0 +1,185 @@
+/* Pairing heap.
+
+   See heap.h for basic information.  The greatest element is the
+   root.  The children of each element form a doubly linked list
+   through `next' and `prev', except that the first child's `prev'
+   points to the parent, which is how cut() tells the two cases
+   apart. */
+
+#include "heap.h"
+#include "../debug.h"
+
+static struct heap_elem *meld (struct heap *,
+		struct heap_elem *, struct heap_elem *);
+static struct heap_elem *merge_pairs (struct heap *, struct heap_elem *);
+static void cut (struct heap_elem *);
+
+/* Initializes heap H as an empty heap ordered by LESS, given
+   auxiliary data AUX. */
+void
+heap_init (struct heap *h, heap_less_func *less, void *aux) {
+	ASSERT (h != NULL);
+	ASSERT (less != NULL);
+
+	h->root = NULL;
+	h->elem_cnt = 0;
+	h->less = less;
+	h->aux = aux;
+}
+
+/* Inserts E into heap H. */
+void
+heap_push (struct heap *h, struct heap_elem *e) {
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+
+	e->child = e->next = e->prev = NULL;
+	h->root = meld (h, h->root, e);
+	h->elem_cnt++;
+}
+
+/* Removes and returns the greatest element of heap H, which must
+   not be empty. */
+struct heap_elem *
+heap_pop (struct heap *h) {
+	struct heap_elem *top = heap_top (h);
+
+	ASSERT (top != NULL);
+	heap_remove (h, top);
+	return top;
+}
+
+/* Removes element E, which must be in heap H. */
+void
+heap_remove (struct heap *h, struct heap_elem *e) {
+	struct heap_elem *sub;
+
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+	ASSERT (h->elem_cnt > 0);
+
+	sub = merge_pairs (h, e->child);
+	if (e == h->root)
+		h->root = sub;
+	else {
+		cut (e);
+		h->root = meld (h, h->root, sub);
+	}
+	e->child = NULL;
+	h->elem_cnt--;
+}
+
+/* Restores heap order after E's key, E being in heap H, was
+   increased. */
+void
+heap_increase (struct heap *h, struct heap_elem *e) {
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+
+	if (e == h->root)
+		return;
+
+	/* E is still at least as great as its own children, so its
+	   whole subtree can move. */
+	cut (e);
+	h->root = meld (h, h->root, e);
+}
+
+/* Returns the greatest element of heap H, or NULL if H is
+   empty. */
+struct heap_elem *
+heap_top (const struct heap *h) {
+	ASSERT (h != NULL);
+
+	return h->root;
+}
+
+/* Returns the number of elements in H. */
+size_t
+heap_size (const struct heap *h) {
+	ASSERT (h != NULL);
+
+	return h->elem_cnt;
+}
+
+/* Returns true if H contains no elements, false otherwise. */
+bool
+heap_empty (const struct heap *h) {
+	return heap_size (h) == 0;
+}
+
+/* Melds the trees rooted at A and B, either of which may be NULL,
+   and returns the new root.  A and B must have no siblings. */
+static struct heap_elem *
+meld (struct heap *h, struct heap_elem *a, struct heap_elem *b) {
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+
+	/* Make A the greater one and B its first child. */
+	if (h->less (a, b, h->aux)) {
+		struct heap_elem *tmp = a;
+		a = b;
+		b = tmp;
+	}
+	b->next = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	b->prev = a;
+	a->child = b;
+	a->next = a->prev = NULL;
+	return a;
+}
+
+/* Melds the sibling list starting at FIRST into a single tree,
+   with the standard two passes: meld pairs left to right, then
+   meld the results right to left.  Returns the new root, or NULL
+   if FIRST is NULL. */
+static struct heap_elem *
+merge_pairs (struct heap *h, struct heap_elem *first) {
+	struct heap_elem *pairs = NULL;
+	struct heap_elem *root = NULL;
+
+	/* First pass.  Melded pairs are stacked through `next', so the
+	   rightmost pair ends up on top. */
+	while (first != NULL) {
+		struct heap_elem *a = first;
+		struct heap_elem *b = a->next;
+		struct heap_elem *m;
+
+		first = b != NULL ? b->next : NULL;
+		a->next = a->prev = NULL;
+		if (b != NULL)
+			b->next = b->prev = NULL;
+
+		m = meld (h, a, b);
+		m->next = pairs;
+		pairs = m;
+	}
+
+	/* Second pass. */
+	while (pairs != NULL) {
+		struct heap_elem *p = pairs;
+
+		pairs = p->next;
+		p->next = NULL;
+		root = meld (h, root, p);
+	}
+	return root;
+}
+
+/* Detaches non-root element E, along with its subtree, from its
+   parent and siblings. */
+static void
+cut (struct heap_elem *e) {
+	ASSERT (e->prev != NULL);
+
+	if (e->prev->child == e)
+		e->prev->child = e->next;
+	else
+		e->prev->next = e->next;
+	if (e->next != NULL)
+		e->next->prev = e->prev;
+	e->next = e->prev = NULL;
+}
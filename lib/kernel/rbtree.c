@@ -0,0 +1,314 @@
+/* Red-black tree.
+
+   See rbtree.h for basic information.  Empty subtrees are null
+   pointers and count as black.  The algorithms follow [CLRS]
+   chapter 13, with each node's parent pointer standing in for
+   the sentinel's. */
+
+#include "rbtree.h"
+#include "../debug.h"
+
+static void rotate_left (struct rbtree *, struct rb_node *);
+static void rotate_right (struct rbtree *, struct rb_node *);
+static void replace_child (struct rbtree *, struct rb_node *parent,
+		struct rb_node *old, struct rb_node *new);
+static void insert_fixup (struct rbtree *, struct rb_node *);
+static void remove_fixup (struct rbtree *, struct rb_node *,
+		struct rb_node *parent);
+
+/* Returns true if N is a red node, false if it is black or
+   null. */
+static inline bool
+is_red (const struct rb_node *n) {
+	return n != NULL && n->red;
+}
+
+/* Returns the least node in the subtree rooted at N. */
+static struct rb_node *
+subtree_first (struct rb_node *n) {
+	while (n->left != NULL)
+		n = n->left;
+	return n;
+}
+
+/* Initializes T as an empty tree ordered by LESS, given
+   auxiliary data AUX. */
+void
+rb_init (struct rbtree *t, rb_less_func *less, void *aux) {
+	ASSERT (t != NULL);
+	ASSERT (less != NULL);
+
+	t->root = t->first = NULL;
+	t->node_cnt = 0;
+	t->less = less;
+	t->aux = aux;
+}
+
+/* Inserts N into tree T, after any nodes that compare equal
+   to it. */
+void
+rb_insert (struct rbtree *t, struct rb_node *n) {
+	struct rb_node **link = &t->root;
+	struct rb_node *parent = NULL;
+	bool leftmost = true;
+
+	ASSERT (t != NULL);
+	ASSERT (n != NULL);
+
+	while (*link != NULL) {
+		parent = *link;
+		if (t->less (n, parent, t->aux))
+			link = &parent->left;
+		else {
+			link = &parent->right;
+			leftmost = false;
+		}
+	}
+
+	n->parent = parent;
+	n->left = n->right = NULL;
+	n->red = true;
+	*link = n;
+	if (leftmost)
+		t->first = n;
+	t->node_cnt++;
+
+	insert_fixup (t, n);
+}
+
+/* Removes N, which must be in tree T. */
+void
+rb_remove (struct rbtree *t, struct rb_node *n) {
+	struct rb_node *child, *parent;
+	bool removed_red;
+
+	ASSERT (t != NULL);
+	ASSERT (n != NULL);
+	ASSERT (t->node_cnt > 0);
+
+	if (t->first == n)
+		t->first = rb_next (n);
+
+	if (n->left != NULL && n->right != NULL) {
+		/* Splice N's successor, which has no left child, into
+		   N's place. */
+		struct rb_node *succ = subtree_first (n->right);
+
+		child = succ->right;
+		parent = succ->parent;
+		removed_red = succ->red;
+		if (parent == n)
+			parent = succ;
+		else {
+			if (child != NULL)
+				child->parent = parent;
+			parent->left = child;
+			succ->right = n->right;
+			n->right->parent = succ;
+		}
+		succ->left = n->left;
+		n->left->parent = succ;
+		succ->parent = n->parent;
+		succ->red = n->red;
+		replace_child (t, n->parent, n, succ);
+	} else {
+		child = n->left != NULL ? n->left : n->right;
+		parent = n->parent;
+		removed_red = n->red;
+		if (child != NULL)
+			child->parent = parent;
+		replace_child (t, parent, n, child);
+	}
+	t->node_cnt--;
+
+	if (!removed_red)
+		remove_fixup (t, child, parent);
+}
+
+/* Returns the least node in T, or a null pointer if T is
+   empty. */
+struct rb_node *
+rb_first (const struct rbtree *t) {
+	return t->first;
+}
+
+/* Returns the node after N in its tree, or a null pointer if N
+   is the greatest node. */
+struct rb_node *
+rb_next (const struct rb_node *n) {
+	struct rb_node *parent;
+
+	if (n->right != NULL)
+		return subtree_first (n->right);
+	while ((parent = n->parent) != NULL && n == parent->right)
+		n = parent;
+	return parent;
+}
+
+/* Returns the number of nodes in T. */
+size_t
+rb_size (const struct rbtree *t) {
+	return t->node_cnt;
+}
+
+/* Returns true if T is empty, false otherwise. */
+bool
+rb_empty (const struct rbtree *t) {
+	return t->root == NULL;
+}
+
+/* Makes NEW take OLD's place as PARENT's child, or as the root
+   of T if PARENT is null. */
+static void
+replace_child (struct rbtree *t, struct rb_node *parent,
+		struct rb_node *old, struct rb_node *new) {
+	if (parent == NULL)
+		t->root = new;
+	else if (parent->left == old)
+		parent->left = new;
+	else
+		parent->right = new;
+}
+
+/* Rotates the subtree rooted at X to the left, so that X's right
+   child takes its place. */
+static void
+rotate_left (struct rbtree *t, struct rb_node *x) {
+	struct rb_node *y = x->right;
+
+	x->right = y->left;
+	if (y->left != NULL)
+		y->left->parent = x;
+	y->parent = x->parent;
+	replace_child (t, x->parent, x, y);
+	y->left = x;
+	x->parent = y;
+}
+
+/* Rotates the subtree rooted at X to the right, so that X's left
+   child takes its place. */
+static void
+rotate_right (struct rbtree *t, struct rb_node *x) {
+	struct rb_node *y = x->left;
+
+	x->left = y->right;
+	if (y->right != NULL)
+		y->right->parent = x;
+	y->parent = x->parent;
+	replace_child (t, x->parent, x, y);
+	y->right = x;
+	x->parent = y;
+}
+
+/* Restores the red-black properties after red node N has been
+   inserted into T. */
+static void
+insert_fixup (struct rbtree *t, struct rb_node *n) {
+	struct rb_node *p;
+
+	while (is_red (p = n->parent)) {
+		/* P is red, so it is not the root and has a parent. */
+		struct rb_node *g = p->parent;
+
+		if (p == g->left) {
+			struct rb_node *u = g->right;
+
+			if (is_red (u)) {
+				p->red = u->red = false;
+				g->red = true;
+				n = g;
+				continue;
+			}
+			if (n == p->right) {
+				rotate_left (t, p);
+				n = p;
+				p = n->parent;
+			}
+			p->red = false;
+			g->red = true;
+			rotate_right (t, g);
+		} else {
+			struct rb_node *u = g->left;
+
+			if (is_red (u)) {
+				p->red = u->red = false;
+				g->red = true;
+				n = g;
+				continue;
+			}
+			if (n == p->left) {
+				rotate_right (t, p);
+				n = p;
+				p = n->parent;
+			}
+			p->red = false;
+			g->red = true;
+			rotate_left (t, g);
+		}
+	}
+	t->root->red = false;
+}
+
+/* Restores the red-black properties after a black node has been
+   removed from T.  X, which may be null, took the removed node's
+   place as a child of PARENT and carries an extra black. */
+static void
+remove_fixup (struct rbtree *t, struct rb_node *x, struct rb_node *parent) {
+	while (x != t->root && !is_red (x)) {
+		if (x == parent->left) {
+			struct rb_node *w = parent->right;
+
+			if (is_red (w)) {
+				w->red = false;
+				parent->red = true;
+				rotate_left (t, parent);
+				w = parent->right;
+			}
+			if (!is_red (w->left) && !is_red (w->right)) {
+				w->red = true;
+				x = parent;
+				parent = x->parent;
+			} else {
+				if (!is_red (w->right)) {
+					w->left->red = false;
+					w->red = true;
+					rotate_right (t, w);
+					w = parent->right;
+				}
+				w->red = parent->red;
+				parent->red = false;
+				w->right->red = false;
+				rotate_left (t, parent);
+				x = t->root;
+			}
+		} else {
+			struct rb_node *w = parent->left;
+
+			if (is_red (w)) {
+				w->red = false;
+				parent->red = true;
+				rotate_right (t, parent);
+				w = parent->left;
+			}
+			if (!is_red (w->left) && !is_red (w->right)) {
+				w->red = true;
+				x = parent;
+				parent = x->parent;
+			} else {
+				if (!is_red (w->left)) {
+					w->right->red = false;
+					w->red = true;
+					rotate_left (t, w);
+					w = parent->left;
+				}
+				w->red = parent->red;
+				parent->red = false;
+				w->left->red = false;
+				rotate_right (t, parent);
+				x = t->root;
+			}
+		}
+	}
+	if (x != NULL)
+		x->red = false;
+}
@@ -198,3 +198,23 @@ int
 umount (const char *path) {
 	return syscall1 (SYS_UMOUNT, path);
 }
+
+int
+getnice (void) {
+	return syscall0 (SYS_GETNICE);
+}
+
+void
+setnice (int nice) {
+	syscall1 (SYS_SETNICE, nice);
+}
+
+int
+getpriority (void) {
+	return syscall0 (SYS_GETPRIORITY);
+}
+
+void
+setpriority (int priority) {
+	syscall1 (SYS_SETPRIORITY, priority);
+}
@@ -0,0 +1,94 @@
+/* Checks that the completely fair scheduler divides the CPU in
+   proportion to thread weight.
+
+   Three threads at priorities PRI_DEFAULT - 8, PRI_DEFAULT, and
+   PRI_DEFAULT + 8 spin for 20 seconds, counting the timer ticks
+   they see.  With weights growing by 10% per priority level,
+   they should receive about 13%, 28%, and 59% of the ticks.
+   Each thread passes if its share is within 5% of the total of
+   what its weight predicts. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 3
+#define PRI_STEP 8
+
+struct thread_info
+  {
+    int64_t start_time;
+    int tick_count;
+  };
+
+static thread_func load_thread;
+
+void
+test_cfs_fair (void)
+{
+  struct thread_info info[THREAD_CNT];
+  unsigned weight[THREAD_CNT], weight_sum = 0;
+  int total = 0;
+  int64_t start_time;
+  int i;
+
+  ASSERT (thread_cfs);
+
+  /* Stay ahead of the load threads while starting them. */
+  thread_set_priority (PRI_MAX);
+
+  start_time = timer_ticks ();
+  msg ("Starting %d threads...", THREAD_CNT);
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      int priority = PRI_DEFAULT + (i - 1) * PRI_STEP;
+      char name[16];
+
+      info[i].start_time = start_time;
+      info[i].tick_count = 0;
+      weight[i] = thread_cfs_weight (priority);
+      weight_sum += weight[i];
+
+      snprintf (name, sizeof name, "load %d", i);
+      thread_create (name, priority, load_thread, &info[i]);
+    }
+
+  msg ("Sleeping 23 seconds to let threads run, please wait...");
+  timer_sleep (23 * TIMER_FREQ);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    total += info[i].tick_count;
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      int expected = (int64_t) total * weight[i] / weight_sum;
+      int diff = info[i].tick_count - expected;
+
+      if (diff < 0)
+        diff = -diff;
+      if (diff > total / 20)
+        fail ("Thread %d received %d of %d ticks, expected about %d.",
+              i, info[i].tick_count, total, expected);
+      msg ("Thread %d received its fair share.", i);
+    }
+}
+
+static void
+load_thread (void *ti_)
+{
+  struct thread_info *ti = ti_;
+  int64_t sleep_time = 2 * TIMER_FREQ;
+  int64_t spin_time = sleep_time + 20 * TIMER_FREQ;
+  int64_t last_time = 0;
+
+  timer_sleep (sleep_time - timer_elapsed (ti->start_time));
+  while (timer_elapsed (ti->start_time) < spin_time)
+    {
+      int64_t cur_time = timer_ticks ();
+      if (cur_time != last_time)
+        ti->tick_count++;
+      last_time = cur_time;
+    }
+}
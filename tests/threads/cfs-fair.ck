@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(cfs-fair) begin
+(cfs-fair) Starting 3 threads...
+(cfs-fair) Sleeping 23 seconds to let threads run, please wait...
+(cfs-fair) Thread 0 received its fair share.
+(cfs-fair) Thread 1 received its fair share.
+(cfs-fair) Thread 2 received its fair share.
+(cfs-fair) end
+EOF
+pass;
@@ -0,0 +1,56 @@
+/* Checks EDF admission control and that an EDF thread runs ahead
+   of normal threads, whatever their priority.
+
+   The main thread reserves half the CPU, then creates a normal
+   thread at PRI_MAX, which must not preempt it.  Once it runs,
+   the new thread is refused a reservation that would overcommit
+   the CPU but granted one that fits.  Finally the main thread is
+   refused a full CPU and parameters with runtime > deadline. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func rt_thread;
+
+void
+test_edf_admit (void)
+{
+  struct semaphore done;
+
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done, 0);
+  if (!thread_set_edf (50, 100, 100))
+    fail ("50/100 reservation refused on an idle CPU.");
+  msg ("Reserved 50%% of the CPU.");
+
+  thread_create ("rt", PRI_MAX, rt_thread, &done);
+  msg ("Main thread still running after creating a PRI_MAX thread.");
+  sema_down (&done);
+
+  if (thread_set_edf (100, 100, 100))
+    fail ("Full-CPU reservation admitted.");
+  msg ("Full-CPU reservation refused.");
+  if (thread_set_edf (60, 100, 50))
+    fail ("Reservation with runtime > deadline admitted.");
+  msg ("Reservation with runtime > deadline refused.");
+  thread_clear_edf ();
+}
+
+static void
+rt_thread (void *done_)
+{
+  struct semaphore *done = done_;
+
+  if (thread_set_edf (60, 100, 100))
+    fail ("60/100 reservation admitted on top of 50/100.");
+  msg ("60/100 reservation refused.");
+  if (!thread_set_edf (40, 100, 100))
+    fail ("40/100 reservation refused on top of 50/100.");
+  msg ("40/100 reservation admitted.");
+  thread_clear_edf ();
+  sema_up (done);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-admit) begin
+(edf-admit) Reserved 50% of the CPU.
+(edf-admit) Main thread still running after creating a PRI_MAX thread.
+(edf-admit) 60/100 reservation refused.
+(edf-admit) 40/100 reservation admitted.
+(edf-admit) Full-CPU reservation refused.
+(edf-admit) Reservation with runtime > deadline refused.
+(edf-admit) end
+EOF
+pass;
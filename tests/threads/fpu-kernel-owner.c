@@ -0,0 +1,81 @@
+/* Checks that a kernel_fpu_begin() section in one thread does not
+   clobber the FPU state of the thread that owns the FPU.
+
+   The main thread becomes the FPU owner the way the #NM handler
+   would make it, by calling fpu_restore_current(), and leaves a
+   pattern in xmm15 that exists only in the registers.  A
+   higher-priority thread then runs a section that must find
+   xmm15 clear and overwrites it.  When the main thread reloads
+   its state, xmm15 must hold its own pattern again. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/fpu.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func other_thread;
+
+static const uint64_t main_pattern[2] = { 0x0123456789abcdef, 0xfedcba9876543210 };
+static const uint64_t other_pattern[2] = { 0x1111222233334444, 0x5555666677778888 };
+
+static void
+set_xmm15 (const uint64_t v[2])
+{
+  asm volatile ("movdqu %0, %%xmm15" : : "m" (*(const uint64_t (*)[2]) v)
+                : "xmm15");
+}
+
+static void
+get_xmm15 (uint64_t v[2])
+{
+  asm volatile ("movdqu %%xmm15, %0" : "=m" (*(uint64_t (*)[2]) v));
+}
+
+void
+test_fpu_kernel_owner (void)
+{
+  struct semaphore done;
+  uint64_t cur[2];
+
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done, 0);
+  if (!fpu_restore_current ())
+    fail ("main: out of memory for FPU state.");
+  set_xmm15 (main_pattern);
+  msg ("main: owns the FPU with a pattern in xmm15.");
+
+  thread_create ("other", PRI_DEFAULT + 1, other_thread, &done);
+  sema_down (&done);
+
+  /* Switching back left CR0.TS set, so reload as #NM would. */
+  if (!fpu_restore_current ())
+    fail ("main: out of memory for FPU state.");
+  get_xmm15 (cur);
+  fpu_release (thread_current ());
+
+  if (cur[0] != main_pattern[0] || cur[1] != main_pattern[1])
+    fail ("main: xmm15 lost its pattern (%016llx %016llx).",
+          (unsigned long long) cur[1], (unsigned long long) cur[0]);
+  msg ("main: xmm15 still holds its pattern.");
+}
+
+static void
+other_thread (void *done_)
+{
+  struct semaphore *done = done_;
+  enum intr_level old_level = kernel_fpu_begin ();
+  uint64_t cur[2];
+
+  get_xmm15 (cur);
+  set_xmm15 (other_pattern);
+  kernel_fpu_end (old_level);
+
+  if (cur[0] != 0 || cur[1] != 0)
+    fail ("other: xmm15 not clear at kernel_fpu_begin().");
+  msg ("other: xmm15 clear at kernel_fpu_begin().");
+  sema_up (done);
+}
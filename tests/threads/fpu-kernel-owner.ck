@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fpu-kernel-owner) begin
+(fpu-kernel-owner) main: owns the FPU with a pattern in xmm15.
+(fpu-kernel-owner) other: xmm15 clear at kernel_fpu_begin().
+(fpu-kernel-owner) main: xmm15 still holds its pattern.
+(fpu-kernel-owner) end
+EOF
+pass;
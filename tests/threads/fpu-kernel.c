@@ -0,0 +1,76 @@
+/* Checks that kernel_fpu_begin() gives kernel code a clean FPU
+   and that nothing loaded between it and kernel_fpu_end() leaks
+   into another thread's section.
+
+   The main thread loads a pattern into xmm15 inside a section,
+   then lets a higher-priority thread run, which must find xmm15
+   clear in its own section and loads a different pattern.  Back
+   in the main thread, a new section must again start clear. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/fpu.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func other_thread;
+
+static const uint64_t main_pattern[2] = { 0x0123456789abcdef, 0xfedcba9876543210 };
+static const uint64_t other_pattern[2] = { 0x1111222233334444, 0x5555666677778888 };
+
+static void
+set_xmm15 (const uint64_t v[2])
+{
+  asm volatile ("movdqu %0, %%xmm15" : : "m" (*(const uint64_t (*)[2]) v)
+                : "xmm15");
+}
+
+static bool
+xmm15_clear (void)
+{
+  uint64_t cur[2];
+
+  asm volatile ("movdqu %%xmm15, %0" : "=m" (cur));
+  return cur[0] == 0 && cur[1] == 0;
+}
+
+/* Begins a section, checks that xmm15 starts clear, loads V, and
+   ends the section. */
+static void
+fpu_section (const char *who, const uint64_t v[2])
+{
+  enum intr_level old_level = kernel_fpu_begin ();
+  bool clear = xmm15_clear ();
+
+  set_xmm15 (v);
+  kernel_fpu_end (old_level);
+
+  if (!clear)
+    fail ("%s: xmm15 not clear at kernel_fpu_begin().", who);
+  msg ("%s: xmm15 clear at kernel_fpu_begin().", who);
+}
+
+void
+test_fpu_kernel (void)
+{
+  struct semaphore done;
+
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done, 0);
+  fpu_section ("main", main_pattern);
+  thread_create ("other", PRI_DEFAULT + 1, other_thread, &done);
+  sema_down (&done);
+  fpu_section ("main", main_pattern);
+}
+
+static void
+other_thread (void *done_)
+{
+  struct semaphore *done = done_;
+
+  fpu_section ("other", other_pattern);
+  sema_up (done);
+}
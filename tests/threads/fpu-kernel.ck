@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fpu-kernel) begin
+(fpu-kernel) main: xmm15 clear at kernel_fpu_begin().
+(fpu-kernel) other: xmm15 clear at kernel_fpu_begin().
+(fpu-kernel) main: xmm15 clear at kernel_fpu_begin().
+(fpu-kernel) end
+EOF
+pass;
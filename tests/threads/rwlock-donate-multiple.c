@@ -0,0 +1,73 @@
+/* The main thread acquires rwlock A for reading and rwlock B for
+   writing, then it creates two higher-priority threads.  Thread a
+   blocks writing A and thread b blocks reading B, and each donates
+   its priority to the main thread, which holds both rwlocks at
+   once.  The main thread releases the rwlocks in turn and
+   relinquishes its donated priorities. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func a_thread_func;
+static thread_func b_thread_func;
+
+void
+test_rwlock_donate_multiple (void)
+{
+  struct rwlock a, b;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&a);
+  rwlock_init (&b);
+
+  rwlock_acquire_read (&a);
+  rwlock_acquire_write (&b);
+
+  thread_create ("a", PRI_DEFAULT + 1, a_thread_func, &a);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 1, thread_get_priority ());
+
+  thread_create ("b", PRI_DEFAULT + 2, b_thread_func, &b);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 2, thread_get_priority ());
+
+  rwlock_release_write (&b);
+  msg ("Thread b should have just finished.");
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 1, thread_get_priority ());
+
+  rwlock_release_read (&a);
+  msg ("Thread a should have just finished.");
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+}
+
+static void
+a_thread_func (void *rw_)
+{
+  struct rwlock *rw = rw_;
+
+  rwlock_acquire_write (rw);
+  msg ("Thread a acquired rwlock a for writing.");
+  rwlock_release_write (rw);
+  msg ("Thread a finished.");
+}
+
+static void
+b_thread_func (void *rw_)
+{
+  struct rwlock *rw = rw_;
+
+  rwlock_acquire_read (rw);
+  msg ("Thread b acquired rwlock b for reading.");
+  rwlock_release_read (rw);
+  msg ("Thread b finished.");
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-donate-multiple) begin
+(rwlock-donate-multiple) Main thread should have priority 32.  Actual priority: 32.
+(rwlock-donate-multiple) Main thread should have priority 33.  Actual priority: 33.
+(rwlock-donate-multiple) Thread b acquired rwlock b for reading.
+(rwlock-donate-multiple) Thread b finished.
+(rwlock-donate-multiple) Thread b should have just finished.
+(rwlock-donate-multiple) Main thread should have priority 32.  Actual priority: 32.
+(rwlock-donate-multiple) Thread a acquired rwlock a for writing.
+(rwlock-donate-multiple) Thread a finished.
+(rwlock-donate-multiple) Thread a should have just finished.
+(rwlock-donate-multiple) Main thread should have priority 31.  Actual priority: 31.
+(rwlock-donate-multiple) end
+EOF
+pass;
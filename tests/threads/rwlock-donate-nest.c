@@ -0,0 +1,91 @@
+/* Low-priority main thread L acquires rwlock RW for writing.
+   Medium-priority thread M then acquires lock A and blocks on
+   acquiring RW for reading.  High-priority thread H then blocks
+   on acquiring lock A.  Thus, thread H donates its priority to
+   M, and the donation must pass through M's wait on RW to reach
+   the writer L. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+struct locks
+  {
+    struct rwlock *rw;
+    struct lock *a;
+  };
+
+static thread_func medium_thread_func;
+static thread_func high_thread_func;
+
+void
+test_rwlock_donate_nest (void)
+{
+  struct rwlock rw;
+  struct lock a;
+  struct locks locks;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rw);
+  lock_init (&a);
+
+  rwlock_acquire_write (&rw);
+
+  locks.rw = &rw;
+  locks.a = &a;
+  thread_create ("medium", PRI_DEFAULT + 1, medium_thread_func, &locks);
+  thread_yield ();
+  msg ("Low thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 1, thread_get_priority ());
+
+  thread_create ("high", PRI_DEFAULT + 2, high_thread_func, &a);
+  thread_yield ();
+  msg ("Low thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 2, thread_get_priority ());
+
+  rwlock_release_write (&rw);
+  thread_yield ();
+  msg ("Medium thread should just have finished.");
+  msg ("Low thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+}
+
+static void
+medium_thread_func (void *locks_)
+{
+  struct locks *locks = locks_;
+
+  lock_acquire (locks->a);
+  rwlock_acquire_read (locks->rw);
+
+  msg ("Medium thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 2, thread_get_priority ());
+  msg ("Medium thread got the rwlock.");
+
+  rwlock_release_read (locks->rw);
+  thread_yield ();
+
+  lock_release (locks->a);
+  thread_yield ();
+
+  msg ("High thread should have just finished.");
+  msg ("Middle thread finished.");
+}
+
+static void
+high_thread_func (void *lock_)
+{
+  struct lock *lock = lock_;
+
+  lock_acquire (lock);
+  msg ("High thread got the lock.");
+  lock_release (lock);
+  msg ("High thread finished.");
+}
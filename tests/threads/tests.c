@@ -29,6 +29,14 @@ static const struct test tests[] =
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
     {"priority-condvar", test_priority_condvar},
+    {"cfs-fair", test_cfs_fair},
+    {"edf-admit", test_edf_admit},
+    {"thread-create-bench", test_thread_create_bench},
+    {"rwlock-donate-nest", test_rwlock_donate_nest},
+    {"fpu-kernel", test_fpu_kernel},
+    {"fpu-kernel-owner", test_fpu_kernel_owner},
+    {"workqueue-order", test_workqueue_order},
+    {"rwlock-donate-multiple", test_rwlock_donate_multiple},
     {"mlfqs-load-1", test_mlfqs_load_1},
     {"mlfqs-load-60", test_mlfqs_load_60},
     {"mlfqs-load-avg", test_mlfqs_load_avg},
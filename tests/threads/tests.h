@@ -23,6 +23,14 @@ extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
 extern test_func test_priority_condvar;
+extern test_func test_cfs_fair;
+extern test_func test_edf_admit;
+extern test_func test_thread_create_bench;
+extern test_func test_rwlock_donate_nest;
+extern test_func test_fpu_kernel;
+extern test_func test_fpu_kernel_owner;
+extern test_func test_workqueue_order;
+extern test_func test_rwlock_donate_multiple;
 extern test_func test_mlfqs_load_1;
 extern test_func test_mlfqs_load_60;
 extern test_func test_mlfqs_load_avg;
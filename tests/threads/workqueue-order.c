@@ -0,0 +1,92 @@
+/* Checks deferred work queued from an interrupt handler.
+
+   A timer callback queues works A, B, and C on a private
+   workqueue, then A again, which must coalesce with the pending A.
+   The worker, at a higher priority than the main thread, runs them
+   in the order queued.  A queues itself again while running, which
+   must succeed because A is no longer pending once it starts, and
+   must run in the same batch, after C. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "devices/timer.h"
+
+#define RUN_MAX 8
+
+static struct workqueue wq;
+static struct work works[3];        /* A, B, and C. */
+static struct semaphore done;
+
+static char run_order[RUN_MAX + 1]; /* Names of works run, in order. */
+static int run_cnt;
+static bool queued[4];              /* Results of the timer's work_queue() calls. */
+static bool requeued;               /* Result of A queuing itself. */
+
+static void queue_works (void *aux);
+static work_func record_work;
+
+void
+test_workqueue_order (void)
+{
+  struct timer timer;
+  int i;
+
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done, 0);
+  workqueue_create (&wq, "wq_test", PRI_DEFAULT + 1);
+  for (i = 0; i < 3; i++)
+    work_init (&works[i], record_work, (void *) (intptr_t) ('A' + i));
+
+  timer_add (&timer, timer_ticks () + 1, queue_works, NULL);
+  sema_down (&done);
+
+  if (!queued[0] || !queued[1] || !queued[2])
+    fail ("Timer callback failed to queue an idle work.");
+  if (queued[3])
+    fail ("Pending work queued twice.");
+  msg ("Second queuing of pending A coalesced.");
+
+  if (!requeued)
+    fail ("Running work failed to queue itself again.");
+  msg ("A queued itself again while running.");
+
+  msg ("Works ran in order %s.", run_order);
+  msg ("%lld queued, %lld coalesced, %lld batches (largest %lld).",
+       wq.queued, wq.coalesced, wq.batches, wq.max_batch);
+}
+
+/* Timer callback, run in the timer interrupt. */
+static void
+queue_works (void *aux UNUSED)
+{
+  queued[0] = work_queue (&wq, &works[0]);
+  queued[1] = work_queue (&wq, &works[1]);
+  queued[2] = work_queue (&wq, &works[2]);
+  queued[3] = work_queue (&wq, &works[0]);
+}
+
+/* Records that the work named by NAME_ ran.  A queues itself
+   again the first time, and ends the test the second time. */
+static void
+record_work (void *name_)
+{
+  char name = (intptr_t) name_;
+  bool first = strchr (run_order, name) == NULL;
+
+  if (run_cnt < RUN_MAX)
+    run_order[run_cnt++] = name;
+  if (name == 'A')
+    {
+      if (first)
+        requeued = work_queue (&wq, &works[0]);
+      else
+        sema_up (&done);
+    }
+}
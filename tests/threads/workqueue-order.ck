@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(workqueue-order) begin
+(workqueue-order) Second queuing of pending A coalesced.
+(workqueue-order) A queued itself again while running.
+(workqueue-order) Works ran in order ABCA.
+(workqueue-order) 4 queued, 1 coalesced, 1 batches (largest 4).
+(workqueue-order) end
+EOF
+pass;
@@ -0,0 +1,20 @@
+/* Child process run by fpu-switch.
+   Checks that an exec'd program starts with a clear xmm15, even
+   though the process that exec'd it had loaded a pattern there. */
+
+#include <stdint.h>
+#include "tests/lib.h"
+
+int
+main (void)
+{
+  uint64_t cur[2];
+
+  test_name = "child-fpu";
+
+  asm volatile ("movdqu %%xmm15, %0" : "=m" (cur));
+  if (cur[0] != 0 || cur[1] != 0)
+    fail ("xmm15 not clear after exec");
+  msg ("xmm15 starts clear");
+  return 83;
+}
@@ -0,0 +1,72 @@
+/* Checks that lazy FPU switching keeps each process's SSE
+   registers to itself across fork, preemption, and exec.
+
+   The parent loads a pattern into xmm15 and forks.  The child
+   must see the parent's pattern, then loads its own, spins long
+   enough to be preempted, and execs child-fpu, which must start
+   with xmm15 clear.  Meanwhile the parent spins too, and after
+   waiting for the child its pattern must still be there. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Iterations of each spin, enough for several time slices. */
+#define SPIN_CNT 2000000
+
+static const uint64_t parent_pattern[2] = { 0x0123456789abcdef, 0xfedcba9876543210 };
+static const uint64_t child_pattern[2] = { 0x1111222233334444, 0x5555666677778888 };
+
+static void
+set_xmm15 (const uint64_t v[2])
+{
+  asm volatile ("movdqu %0, %%xmm15" : : "m" (*(const uint64_t (*)[2]) v)
+                : "xmm15");
+}
+
+static bool
+xmm15_is (const uint64_t v[2])
+{
+  uint64_t cur[2];
+
+  asm volatile ("movdqu %%xmm15, %0" : "=m" (cur));
+  return cur[0] == v[0] && cur[1] == v[1];
+}
+
+/* Checks that xmm15 holds V for SPIN_CNT iterations. */
+static bool
+spin_check (const uint64_t v[2])
+{
+  int i;
+
+  for (i = 0; i < SPIN_CNT; i++)
+    if (!xmm15_is (v))
+      return false;
+  return true;
+}
+
+void
+test_main (void)
+{
+  int pid;
+
+  set_xmm15 (parent_pattern);
+  if ((pid = fork ("child-fpu")))
+    {
+      /* Report only after the child is done, to keep the output
+         in a fixed order. */
+      bool kept = spin_check (parent_pattern);
+
+      CHECK (wait (pid) == 83, "wait for child");
+      CHECK (kept, "parent: xmm15 kept while child runs");
+      CHECK (xmm15_is (parent_pattern), "parent: xmm15 kept after child exits");
+    }
+  else
+    {
+      CHECK (xmm15_is (parent_pattern), "child: xmm15 inherited from parent");
+      set_xmm15 (child_pattern);
+      CHECK (spin_check (child_pattern), "child: xmm15 kept while parent runs");
+      exec ("child-fpu");
+    }
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fpu-switch) begin
+(fpu-switch) child: xmm15 inherited from parent
+(fpu-switch) child: xmm15 kept while parent runs
+(child-fpu) xmm15 starts clear
+child-fpu: exit(83)
+(fpu-switch) wait for child
+(fpu-switch) parent: xmm15 kept while child runs
+(fpu-switch) parent: xmm15 kept after child exits
+(fpu-switch) end
+fpu-switch: exit(0)
+EOF
+pass;
@@ -0,0 +1,263 @@
+#include "threads/fpu.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+/* Lazy FPU context switching.
+
+   Only one thread's x87/SSE register state (plus AVX, if XSAVE is
+   available) is loaded in the FPU at a time, that of fpu_owner.
+   Switching to any other thread sets CR0.TS, so the first FPU
+   instruction it executes raises #NM.  The #NM handler saves the
+   owner's state, loads the current thread's, and makes it the
+   new owner.  Threads that never touch the FPU, which includes
+   every kernel thread, never pay for a save or restore and have
+   no state area at all. */
+
+#define CR0_MP (1 << 1)             /* Monitor coprocessor. */
+#define CR0_EM (1 << 2)             /* x87 emulation. */
+#define CR0_TS (1 << 3)             /* Task switched. */
+#define CR4_OSFXSR (1 << 9)         /* FXSAVE/FXRSTOR and SSE enabled. */
+#define CR4_OSXMMEXCPT (1 << 10)    /* Unmasked SSE exceptions -> #XF. */
+#define CR4_OSXSAVE (1 << 18)       /* XSAVE and XCR0 enabled. */
+
+#define CPUID1_ECX_XSAVE (1 << 26)
+#define CPUID1_ECX_AVX (1 << 28)
+
+#define XCR0_X87 (1 << 0)
+#define XCR0_SSE (1 << 1)
+#define XCR0_AVX (1 << 2)
+
+#define FXSAVE_SIZE 512             /* Size of an FXSAVE area. */
+#define FPU_ALIGN 64                /* XSAVE area alignment. */
+#define MXCSR_DEFAULT 0x1f80        /* All SSE exceptions masked. */
+
+static bool use_xsave;              /* XSAVE instead of FXSAVE? */
+static size_t fpu_size;             /* Size of a state area. */
+static struct thread *fpu_owner;    /* Thread whose state is loaded. */
+static bool ts_set;                 /* Cached value of CR0.TS. */
+
+/* Freshly initialized state that new state areas start from. */
+static uint8_t init_state[4096] __attribute__ ((aligned (FPU_ALIGN)));
+
+static long long save_cnt;          /* # of state saves. */
+static long long restore_cnt;       /* # of state restores. */
+
+static void set_ts (bool);
+static void *fpu_area (const struct thread *);
+static bool fpu_alloc (struct thread *);
+static void fpu_save (void *);
+static void fpu_restore (const void *);
+
+/* Enables SSE, and XSAVE with AVX when the CPU supports it, and
+   captures the initial FPU state. */
+void
+fpu_init (void) {
+	uint32_t eax, ebx, ecx, edx;
+	uint32_t mxcsr = MXCSR_DEFAULT;
+	uint64_t cr4;
+
+	cpuid (1, 0, &eax, &ebx, &ecx, &edx);
+
+	lcr0 ((rcr0 () & ~(CR0_EM | CR0_TS)) | CR0_MP);
+	ts_set = false;
+
+	cr4 = rcr4 () | CR4_OSFXSR | CR4_OSXMMEXCPT;
+	use_xsave = (ecx & CPUID1_ECX_XSAVE) != 0;
+	if (use_xsave) {
+		uint64_t xcr0 = XCR0_X87 | XCR0_SSE;
+
+		if (ecx & CPUID1_ECX_AVX)
+			xcr0 |= XCR0_AVX;
+		lcr4 (cr4 | CR4_OSXSAVE);
+		xsetbv (0, xcr0);
+
+		/* EBX is the area size for the features now in XCR0. */
+		cpuid (0xd, 0, &eax, &ebx, &ecx, &edx);
+		fpu_size = ebx;
+	} else {
+		lcr4 (cr4);
+		fpu_size = FXSAVE_SIZE;
+	}
+	ASSERT (fpu_size <= sizeof init_state);
+
+	asm volatile ("fninit");
+	asm volatile ("ldmxcsr %0" : : "m" (mxcsr));
+	fpu_save (init_state);
+
+	set_ts (true);
+}
+
+/* Called by the scheduler, with interrupts off, just before
+   switching to NEXT.  Leaves the FPU enabled only if NEXT's state
+   is the one loaded. */
+void
+fpu_switch (struct thread *next) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	set_ts (next != fpu_owner);
+}
+
+/* Handles #NM for the current thread: saves the previous owner's
+   state and loads the current thread's, allocating a fresh one on
+   first use.  Returns false if no memory is available for it. */
+bool
+fpu_restore_current (void) {
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+
+	if (cur->fpu == NULL && !fpu_alloc (cur))
+		return false;
+
+	old_level = intr_disable ();
+	set_ts (false);
+	if (fpu_owner != cur) {
+		if (fpu_owner != NULL) {
+			fpu_save (fpu_area (fpu_owner));
+			save_cnt++;
+		}
+		fpu_restore (fpu_area (cur));
+		restore_cnt++;
+		fpu_owner = cur;
+	}
+	intr_set_level (old_level);
+	return true;
+}
+
+/* Gives CHILD a copy of PARENT's FPU state, if PARENT has any.
+   PARENT must not be running.  Returns false if out of memory. */
+bool
+fpu_fork (struct thread *child, struct thread *parent) {
+	enum intr_level old_level;
+
+	if (parent->fpu == NULL)
+		return true;
+	if (!fpu_alloc (child))
+		return false;
+
+	old_level = intr_disable ();
+	if (fpu_owner == parent) {
+		/* The registers hold PARENT's latest state.  It stays the
+		   owner, since the registers still match the saved copy. */
+		set_ts (false);
+		fpu_save (fpu_area (parent));
+		save_cnt++;
+		set_ts (true);
+	}
+	memcpy (fpu_area (child), fpu_area (parent), fpu_size);
+	intr_set_level (old_level);
+	return true;
+}
+
+/* Discards T's FPU state, so that its next FPU instruction starts
+   from a clean state.  T must be the current thread. */
+void
+fpu_release (struct thread *t) {
+	enum intr_level old_level;
+	void *fpu;
+
+	ASSERT (t == thread_current ());
+
+	old_level = intr_disable ();
+	if (fpu_owner == t) {
+		fpu_owner = NULL;
+		set_ts (true);
+	}
+	fpu = t->fpu;
+	t->fpu = NULL;
+	intr_set_level (old_level);
+
+	free (fpu);
+}
+
+/* Saves the owner's FPU state, if any, and gives the kernel a
+   clean FPU.  Returns the previous interrupt level, to be passed
+   to kernel_fpu_end(). */
+enum intr_level
+kernel_fpu_begin (void) {
+	enum intr_level old_level = intr_disable ();
+
+	set_ts (false);
+	if (fpu_owner != NULL) {
+		fpu_save (fpu_area (fpu_owner));
+		save_cnt++;
+		fpu_owner = NULL;
+	}
+	fpu_restore (init_state);
+	return old_level;
+}
+
+/* Ends a section begun with kernel_fpu_begin().  The thread that
+   owned the FPU before reloads its state on its next #NM. */
+void
+kernel_fpu_end (enum intr_level old_level) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	set_ts (true);
+	intr_set_level (old_level);
+}
+
+/* Prints FPU statistics. */
+void
+fpu_print_stats (void) {
+	printf ("FPU: %s, %lld saves, %lld restores\n",
+			use_xsave ? "xsave" : "fxsave", save_cnt, restore_cnt);
+}
+
+/* Sets CR0.TS to ON, touching CR0 only if it changes. */
+static void
+set_ts (bool on) {
+	if (on == ts_set)
+		return;
+	if (on)
+		lcr0 (rcr0 () | CR0_TS);
+	else
+		asm volatile ("clts");
+	ts_set = on;
+}
+
+/* Returns the aligned state area of thread T. */
+static void *
+fpu_area (const struct thread *t) {
+	return (void *) ROUND_UP ((uintptr_t) t->fpu, FPU_ALIGN);
+}
+
+/* Gives T a state area holding the initial FPU state.  The
+   allocation is padded so that it can be aligned to FPU_ALIGN. */
+static bool
+fpu_alloc (struct thread *t) {
+	ASSERT (t->fpu == NULL);
+
+	t->fpu = malloc (fpu_size + FPU_ALIGN - 1);
+	if (t->fpu == NULL)
+		return false;
+	memcpy (fpu_area (t), init_state, fpu_size);
+	return true;
+}
+
+/* Saves the FPU registers into AREA. */
+static void
+fpu_save (void *area) {
+	if (use_xsave)
+		asm volatile ("xsave64 %0" : "=m" (*(uint8_t (*)[FXSAVE_SIZE]) area)
+				: "a" (-1), "d" (-1) : "memory");
+	else
+		asm volatile ("fxsave64 %0" : "=m" (*(uint8_t (*)[FXSAVE_SIZE]) area)
+				: : "memory");
+}
+
+/* Loads the FPU registers from AREA. */
+static void
+fpu_restore (const void *area) {
+	if (use_xsave)
+		asm volatile ("xrstor64 %0" : : "m" (*(const uint8_t (*)[FXSAVE_SIZE]) area),
+				"a" (-1), "d" (-1) : "memory");
+	else
+		asm volatile ("fxrstor64 %0" : : "m" (*(const uint8_t (*)[FXSAVE_SIZE]) area)
+				: "memory");
+}
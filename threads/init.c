@@ -1,6 +1,7 @@
 #include "threads/init.h"
 #include <console.h>
 #include <debug.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <random.h>
 #include <stddef.h>
@@ -13,6 +14,7 @@
 #include "devices/serial.h"
 #include "devices/timer.h"
 #include "devices/vga.h"
+#include "threads/fpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
@@ -20,7 +22,12 @@
 #include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/slab.h"
+#include "threads/switch.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "threads/workqueue.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -85,6 +92,7 @@ main (void) {
 	/* Initialize memory system. */
 	mem_end = palloc_init ();
 	malloc_init ();
+	slab_init ();
 	paging_init (mem_end);
 
 #ifdef USERPROG
@@ -94,6 +102,7 @@ main (void) {
 
 	/* Initialize interrupt handlers. */
 	intr_init ();
+	fpu_init ();
 	timer_init ();
 	kbd_init ();
 	input_init ();
@@ -103,6 +112,7 @@ main (void) {
 #endif
 	/* Start thread scheduler and enable interrupts. */
 	thread_start ();
+	workqueue_init ();
 	serial_init_queue ();
 	timer_calibrate ();
 
@@ -221,6 +231,14 @@ parse_options (char **argv) {
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-cfs"))
+			thread_cfs = true;
+		else if (!strcmp (name, "-tickless"))
+			timer_tickless = true;
+		else if (!strcmp (name, "-lockprof"))
+			lock_profile = true;
+		else if (!strcmp (name, "-intrlat"))
+			intr_latency = true;
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
@@ -231,6 +249,9 @@ parse_options (char **argv) {
 			PANIC ("unknown option `%s' (use -h for help)", name);
 	}
 
+	if (thread_mlfqs && thread_cfs)
+		PANIC ("-mlfqs and -cfs cannot be used together");
+
 	return argv;
 }
 
@@ -252,6 +273,134 @@ run_task (char **argv) {
 	printf ("Execution of '%s' complete.\n", task);
 }
 
+/* Number of round trips timed by run_bench_switch(). */
+#define BENCH_ROUNDS 10000
+
+/* Stack pointers of the two sides of the raw switch_to() loop. */
+static uint64_t bench_main_sp, bench_co_sp;
+
+/* Other side of the thread_yield() ping-pong. */
+static void
+bench_yield_thread (void *done_) {
+	struct semaphore *done = done_;
+	int i;
+
+	for (i = 0; i < BENCH_ROUNDS; i++)
+		thread_yield ();
+	sema_up (done);
+}
+
+/* Other side of the raw switch_to() loop.  Runs on a bare stack,
+   not in a thread, so interrupts must stay off. */
+static void
+bench_coroutine (void *aux UNUSED) {
+	for (;;)
+		switch_to (&bench_co_sp, bench_main_sp);
+}
+
+/* Saves every register into TF and resumes through do_iret(),
+   which is what each kernel-to-kernel switch cost before
+   switch_to(): a full intr_frame spill followed by iretq. */
+static void NO_INLINE
+bench_iret_self (struct intr_frame *tf) {
+	__asm __volatile (
+			"push %%rax\n"
+			"push %%rbx\n"
+			"push %%rcx\n"
+			"movq %0, %%rax\n"
+			"movq %%r15, 0(%%rax)\n"
+			"movq %%r14, 8(%%rax)\n"
+			"movq %%r13, 16(%%rax)\n"
+			"movq %%r12, 24(%%rax)\n"
+			"movq %%r11, 32(%%rax)\n"
+			"movq %%r10, 40(%%rax)\n"
+			"movq %%r9, 48(%%rax)\n"
+			"movq %%r8, 56(%%rax)\n"
+			"movq %%rsi, 64(%%rax)\n"
+			"movq %%rdi, 72(%%rax)\n"
+			"movq %%rbp, 80(%%rax)\n"
+			"movq %%rdx, 88(%%rax)\n"
+			"pop %%rbx\n"              // Saved rcx
+			"movq %%rbx, 96(%%rax)\n"
+			"pop %%rbx\n"              // Saved rbx
+			"movq %%rbx, 104(%%rax)\n"
+			"pop %%rbx\n"              // Saved rax
+			"movq %%rbx, 112(%%rax)\n"
+			"movq %%rax, %%rdi\n"
+			"addq $120, %%rax\n"
+			"movw %%es, (%%rax)\n"
+			"movw %%ds, 8(%%rax)\n"
+			"addq $32, %%rax\n"
+			"leaq 1f(%%rip), %%rbx\n"
+			"movq %%rbx, 0(%%rax)\n" // rip
+			"movw %%cs, 8(%%rax)\n"  // cs
+			"pushfq\n"
+			"popq %%rbx\n"
+			"mov %%rbx, 16(%%rax)\n" // eflags
+			"mov %%rsp, 24(%%rax)\n" // rsp
+			"movw %%ss, 32(%%rax)\n"
+			"call do_iret\n"
+			"1:\n"
+			: : "g" ((uint64_t) tf) : "memory");
+}
+
+/* Times kernel-to-kernel context switches three ways: through
+   the scheduler with thread_yield(), with bare switch_to(), and
+   with the intr_frame + iretq sequence that switch_to() replaced. */
+static void
+run_bench_switch (char **argv UNUSED) {
+	struct semaphore done;
+	struct intr_frame tf;
+	struct switch_frame *sf;
+	enum intr_level old_level;
+	uint64_t start, yield_ns, switch_ns, iret_ns;
+	void *stack;
+	int i;
+
+	printf ("Context switch benchmark, %d round trips:\n", BENCH_ROUNDS);
+
+	/* Ping-pong with an equal-priority thread. */
+	sema_init (&done, 0);
+	if (thread_create ("bench-yield", thread_get_priority (),
+				bench_yield_thread, &done) == TID_ERROR)
+		PANIC ("bench-switch: thread_create failed");
+	start = timer_now_ns ();
+	for (i = 0; i < BENCH_ROUNDS; i++)
+		thread_yield ();
+	yield_ns = timer_now_ns () - start;
+	sema_down (&done);
+
+	/* Bare switch_to() to a stack that switches straight back. */
+	stack = palloc_get_page (0);
+	if (stack == NULL)
+		PANIC ("bench-switch: out of memory");
+	sf = (struct switch_frame *) ((uint8_t *) stack + PGSIZE - 16) - 1;
+	sf->r12 = (uint64_t) bench_coroutine;
+	sf->rip = switch_entry;
+	bench_co_sp = (uint64_t) sf;
+
+	old_level = intr_disable ();
+	start = timer_now_ns ();
+	for (i = 0; i < BENCH_ROUNDS; i++)
+		switch_to (&bench_main_sp, bench_co_sp);
+	switch_ns = timer_now_ns () - start;
+
+	/* Full register spill and iretq, twice per round trip. */
+	start = timer_now_ns ();
+	for (i = 0; i < BENCH_ROUNDS * 2; i++)
+		bench_iret_self (&tf);
+	iret_ns = timer_now_ns () - start;
+	intr_set_level (old_level);
+	palloc_free_page (stack);
+
+	printf ("  thread_yield():      %"PRIu64" ns/switch\n",
+			yield_ns / (BENCH_ROUNDS * 2));
+	printf ("  switch_to():         %"PRIu64" ns/switch\n",
+			switch_ns / (BENCH_ROUNDS * 2));
+	printf ("  intr_frame + iretq:  %"PRIu64" ns/switch\n",
+			iret_ns / (BENCH_ROUNDS * 2));
+}
+
 /* Executes all of the actions specified in ARGV[]
    up to the null pointer sentinel. */
 static void
@@ -266,6 +415,7 @@ run_actions (char **argv) {
 	/* Table of supported actions. */
 	static const struct action actions[] = {
 		{"run", 2, run_task},
+		{"bench-switch", 1, run_bench_switch},
 #ifdef FILESYS
 		{"ls", 1, fsutil_ls},
 		{"cat", 2, fsutil_cat},
@@ -312,6 +462,7 @@ usage (void) {
 #else
 			"  run TEST           Run TEST.\n"
 #endif
+			"  bench-switch       Measure kernel context-switch cost.\n"
 #ifdef FILESYS
 			"  ls                 List files in the root directory.\n"
 			"  cat FILE           Print FILE to the console.\n"
@@ -326,6 +477,10 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -cfs               Use completely fair scheduler.\n"
+			"  -tickless          Stop the timer tick while idle.\n"
+			"  -lockprof          Profile named locks; print at shutdown.\n"
+			"  -intrlat           Track interrupts-off sections; print at shutdown.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
@@ -354,6 +509,13 @@ static void
 print_stats (void) {
 	timer_print_stats ();
 	thread_print_stats ();
+	lock_print_stats ();
+	workqueue_print_stats ();
+	palloc_print_stats ();
+	malloc_print_stats ();
+	kmem_cache_print_stats ();
+	intr_print_latency ();
+	fpu_print_stats ();
 #ifdef FILESYS
 	disk_print_stats ();
 #endif
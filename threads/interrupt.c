@@ -3,6 +3,7 @@
 #include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include "threads/flags.h"
 #include "threads/intr-stubs.h"
 #include "threads/io.h"
@@ -103,6 +104,32 @@ static const char *intr_names[INTR_CNT];
 static bool in_external_intr;   /* Are we processing an external interrupt? */
 static bool yield_on_return;    /* Should we yield on interrupt return? */
 
+/* Interrupts-off latency tracking, enabled by -intrlat.  A section
+   starts when intr_disable() or an external interrupt turns
+   interrupts off and ends when intr_enable() or the end of the
+   interrupt handler turns them back on.  Durations are kept in TSC
+   cycles so that recording them never calls back into the timer,
+   and converted to ns only when printed. */
+#define OFF_BUCKETS 40          /* Histogram buckets, by log2 cycles. */
+#define OFF_WORST 8             /* Longest sections kept, by call site. */
+
+/* Longest section seen for one call site. */
+struct off_record {
+	void *site;                 /* Where interrupts were turned off. */
+	void *end_site;             /* Where they were turned back on. */
+	uint64_t cycles;            /* Longest duration from SITE. */
+	long long cnt;              /* # of sections from SITE while kept. */
+};
+
+bool intr_latency;
+static uint64_t off_start;      /* TSC when interrupts went off, or 0. */
+static void *off_site;          /* Who turned them off. */
+static long long off_hist[OFF_BUCKETS];
+static struct off_record off_worst[OFF_WORST];
+
+static void off_begin (void *site);
+static void off_end (void *end_site);
+
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
 static void pic_end_of_interrupt (int irq);
@@ -124,19 +151,16 @@ intr_get_level (void) {
 	return flags & FLAG_IF ? INTR_ON : INTR_OFF;
 }
 
-/* Enables or disables interrupts as specified by LEVEL and
-   returns the previous interrupt status. */
-enum intr_level
-intr_set_level (enum intr_level level) {
-	return level == INTR_ON ? intr_enable () : intr_disable ();
-}
-
-/* Enables interrupts and returns the previous interrupt status. */
-enum intr_level
-intr_enable (void) {
+/* Enables interrupts on behalf of CALLER and returns the previous
+   interrupt status. */
+static inline enum intr_level
+enable_from (void *caller) {
 	enum intr_level old_level = intr_get_level ();
 	ASSERT (!intr_context ());
 
+	if (old_level == INTR_OFF)
+		off_end (caller);
+
 	/* Enable interrupts by setting the interrupt flag.
 
 	   See [IA32-v2b] "STI" and [IA32-v3a] 5.8.1 "Masking Maskable
@@ -146,9 +170,10 @@ intr_enable (void) {
 	return old_level;
 }
 
-/* Disables interrupts and returns the previous interrupt status. */
-enum intr_level
-intr_disable (void) {
+/* Disables interrupts on behalf of CALLER and returns the previous
+   interrupt status. */
+static inline enum intr_level
+disable_from (void *caller) {
 	enum intr_level old_level = intr_get_level ();
 
 	/* Disable interrupts by clearing the interrupt flag.
@@ -156,9 +181,124 @@ intr_disable (void) {
 	   Hardware Interrupts". */
 	asm volatile ("cli" : : : "memory");
 
+	if (old_level == INTR_ON)
+		off_begin (caller);
+
 	return old_level;
 }
 
+/* Enables or disables interrupts as specified by LEVEL and
+   returns the previous interrupt status. */
+enum intr_level
+intr_set_level (enum intr_level level) {
+	void *caller = __builtin_return_address (0);
+
+	return level == INTR_ON ? enable_from (caller) : disable_from (caller);
+}
+
+/* Enables interrupts and returns the previous interrupt status. */
+enum intr_level
+intr_enable (void) {
+	return enable_from (__builtin_return_address (0));
+}
+
+/* Disables interrupts and returns the previous interrupt status. */
+enum intr_level
+intr_disable (void) {
+	return disable_from (__builtin_return_address (0));
+}
+
+/* Starts an interrupts-off section at SITE.  Interrupts are off. */
+static void
+off_begin (void *site) {
+	if (intr_latency) {
+		off_start = rdtsc ();
+		off_site = site;
+	}
+}
+
+/* Ends the current interrupts-off section, if one is being
+   tracked, at END_SITE.  Interrupts are still off. */
+static void
+off_end (void *end_site) {
+	struct off_record *r, *slot = NULL;
+	uint64_t cycles;
+	int bucket;
+
+	if (off_start == 0)
+		return;
+	cycles = rdtsc () - off_start;
+	off_start = 0;
+
+	bucket = 63 - __builtin_clzll (cycles | 1);
+	if (bucket >= OFF_BUCKETS)
+		bucket = OFF_BUCKETS - 1;
+	off_hist[bucket]++;
+
+	/* Keep one record per call site; otherwise evict the shortest. */
+	for (r = off_worst; r < off_worst + OFF_WORST; r++) {
+		if (r->site == off_site) {
+			slot = r;
+			break;
+		}
+		if (slot == NULL || r->cycles < slot->cycles)
+			slot = r;
+	}
+	if (slot->site == off_site)
+		slot->cnt++;
+	else if (cycles > slot->cycles)
+		*slot = (struct off_record) { off_site, NULL, 0, 1 };
+	else
+		return;
+	if (cycles > slot->cycles) {
+		slot->cycles = cycles;
+		slot->end_site = end_site;
+	}
+}
+
+/* Prints the interrupts-off histogram and the longest sections.
+   May be called at any time; prints nothing unless the kernel ran
+   with -intrlat.  The addresses can be turned into function names
+   with the `backtrace' utility. */
+void
+intr_print_latency (void) {
+	long long hist[OFF_BUCKETS], total = 0;
+	struct off_record worst[OFF_WORST];
+	enum intr_level old_level;
+	int i, j;
+
+	if (!intr_latency)
+		return;
+
+	old_level = intr_disable ();
+	memcpy (hist, off_hist, sizeof hist);
+	memcpy (worst, off_worst, sizeof worst);
+	intr_set_level (old_level);
+
+	for (i = 0; i < OFF_BUCKETS; i++)
+		total += hist[i];
+	printf ("Interrupts off: %lld sections\n", total);
+	for (i = 0; i < OFF_BUCKETS; i++)
+		if (hist[i] != 0)
+			printf ("  >= %10llu ns: %lld\n",
+					timer_tsc_to_ns (1ULL << i), hist[i]);
+
+	/* Longest first. */
+	for (i = 1; i < OFF_WORST; i++)
+		for (j = i; j > 0 && worst[j - 1].cycles < worst[j].cycles; j--) {
+			struct off_record tmp = worst[j];
+			worst[j] = worst[j - 1];
+			worst[j - 1] = tmp;
+		}
+	printf ("Longest interrupts-off sections (off at -> on at):\n");
+	for (i = 0; i < OFF_WORST && worst[i].site != NULL; i++)
+		printf ("  %10llu ns %8lld x  %p -> %p\n",
+				timer_tsc_to_ns (worst[i].cycles), worst[i].cnt,
+				worst[i].site, worst[i].end_site);
+	printf ("The `backtrace' program can turn these addresses into "
+			"function names.\n");
+}
+
 /* Initializes the interrupt system. */
 void
 intr_init (void) {
@@ -338,12 +478,23 @@ intr_handler (struct intr_frame *frame) {
 	   and they need to be acknowledged on the PIC (see below).
 	   An external interrupt handler cannot sleep. */
 	external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
+
+	/* If the interrupted code had interrupts on, any section still
+	   marked open was ended by an iretq or sti we did not see. */
+	if (frame->eflags & FLAG_IF)
+		off_start = 0;
+
 	if (external) {
 		ASSERT (intr_get_level () == INTR_OFF);
 		ASSERT (!intr_context ());
 
 		in_external_intr = true;
 		yield_on_return = false;
+		off_begin (intr_handlers[frame->vec_no]);
+
+		/* Any device interrupt ends a tickless idle period, so
+		   bring the tick count up to date before handling it. */
+		timer_idle_restart_tick ();
 	}
 
 	/* Invoke the interrupt's handler. */
@@ -367,6 +518,7 @@ intr_handler (struct intr_frame *frame) {
 		ASSERT (intr_context ());
 
 		in_external_intr = false;
+		off_end (intr_handlers[frame->vec_no]);
 		pic_end_of_interrupt (frame->vec_no);
 
 		if (yield_on_return)
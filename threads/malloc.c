@@ -5,41 +5,78 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "atomic.h"
 
 /* A simple implementation of malloc().
 
-   The size of each request, in bytes, is rounded up to a power
-   of 2 and assigned to the "descriptor" that manages blocks of
-   that size.  The descriptor keeps a list of free blocks.  If
-   the free list is nonempty, one of its blocks is used to
-   satisfy the request.
-
-   Otherwise, a new page of memory, called an "arena", is
-   obtained from the page allocator (if none is available,
-   malloc() returns a null pointer).  The new arena is divided
-   into blocks, all of which are added to the descriptor's free
-   list.  Then we return one of the new blocks.
+   The size of each request, in bytes, is rounded up to the
+   nearest of a set of size classes spaced about 1.25x apart, and
+   assigned to the "descriptor" that manages blocks of that size.
+   The descriptor keeps a list of free blocks.  If the free list
+   is nonempty, one of its blocks is used to satisfy the request.
+
+   Otherwise, a new "arena" is obtained from the page allocator
+   (if none is available, malloc() returns a null pointer).  The
+   new arena is divided into blocks, all of which are added to
+   the descriptor's free list.  Then we return one of the new
+   blocks.
+
+   Small classes use one-page arenas.  Medium classes, those too
+   big to fit four blocks in a page, use arenas of
+   MEDIUM_ARENA_PAGES pages instead, so that a 1100-byte request
+   does not take a whole page.  A block's arena is found from the
+   block's address: a small arena is the page the block is in,
+   and a medium arena is aligned to its own size, with medium_map
+   recording which aligned chunks of memory are medium arenas.
 
    When we free a block, we add it to its descriptor's free list.
    But if the arena that the block was in now has no in-use
    blocks, we remove all of the arena's blocks from the free list
    and give the arena back to the page allocator.
 
-   We can't handle blocks bigger than 2 kB using this scheme,
-   because they're too big to fit in a single page with a
-   descriptor.  We handle those by allocating contiguous pages
-   with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   We don't handle blocks bigger than MEDIUM_MAX using this
+   scheme.  We handle those by allocating contiguous pages with
+   the page allocator and sticking the allocation size at the
+   beginning of the allocated block's arena header.
+
+   In front of the free lists of the small classes sits a magazine
+   per class: a small stack of free blocks that malloc() pops and
+   free() pushes with interrupts off, without taking the
+   descriptor's lock.  Only when a magazine runs empty or full does
+   the descriptor's lock get taken, to move half a magazine of
+   blocks at a time between the magazine and the free list.  A
+   magazine holds at most MAG_BYTES, because the blocks it holds
+   keep their arenas from going back to the page allocator; for
+   the same reason the medium classes have none.  Magazines are per CPU, and Pintos
+   has one CPU, so there is one set.  (Per-thread magazines would
+   need room in every thread's page, which it shares with the
+   kernel stack.)
+
+   realloc() leaves a block where it is if the new size still
+   fits its class without wasting more than half of it, and
+   shrinks a big block by freeing its tail pages. */
 
 /* Descriptor. */
 struct desc {
 	size_t block_size;          /* Size of each element in bytes. */
 	size_t blocks_per_arena;    /* Number of blocks in an arena. */
+	size_t arena_pages;         /* Pages per arena. */
 	struct list free_list;      /* List of free blocks. */
 	struct lock lock;           /* Lock. */
+	size_t mag_cap;             /* Magazine capacity in blocks. */
+
+	/* Statistics, protected by LOCK. */
+	size_t in_use;              /* Blocks off the free list. */
+	size_t arena_cnt;           /* Arenas held. */
+
+	/* Statistics, updated with interrupts off. */
+	int64_t alloc_cnt;          /* # of blocks handed out. */
+	int64_t req_bytes;          /* Sum of the sizes requested. */
+	int64_t mag_hits;           /* # served from the magazine. */
 };
 
 /* Magic number for detecting arena corruption. */
@@ -57,25 +94,77 @@ struct block {
 	struct list_elem free_elem; /* Free list element. */
 };
 
+/* Largest block in a one-page arena: four blocks must fit. */
+#define SMALL_MAX ((PGSIZE - sizeof (struct arena)) / 4)
+
+/* Largest block that is not a big block. */
+#define MEDIUM_MAX (16 * 1024)
+
+/* Medium arenas: size and alignment. */
+#define MEDIUM_ARENA_PAGES 16
+#define MEDIUM_ARENA_SIZE (MEDIUM_ARENA_PAGES * PGSIZE)
+
+/* Bit N is set if the MEDIUM_ARENA_SIZE bytes of physical memory
+   starting at N * MEDIUM_ARENA_SIZE are a medium arena.  Covers
+   4 GB.  Modified with interrupts off. */
+#define MEDIUM_MAP_BITS (1 << 16)
+static uint64_t medium_map[MEDIUM_MAP_BITS / 64];
+
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+static struct desc descs[32];   /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
+/* Magazine: free blocks of one size class, cached in front of its
+   descriptor.  Accessed with interrupts off. */
+#define MAG_SIZE 16             /* Capacity in blocks, at most. */
+#define MAG_BYTES 2048          /* Capacity in bytes, at most. */
+struct magazine {
+	size_t cnt;                 /* Number of blocks held. */
+	struct block *blocks[MAG_SIZE]; /* Blocks, most recently freed last. */
+};
+
+/* This CPU's magazines, indexed like DESCS. */
+static struct magazine magazines[sizeof descs / sizeof *descs];
+
+/* Big blocks. */
+static int64_t big_alloc_cnt;   /* # of big blocks handed out. */
+static int64_t big_pages;       /* Pages in big blocks now in use. */
+
+static struct desc *desc_for_size (size_t);
+static bool desc_grow (struct desc *);
+static void desc_put (struct desc *, struct block *);
+static struct block *magazine_refill (struct desc *);
+static void magazine_drain (struct desc *, struct block *);
+static struct arena *arena_alloc (struct desc *);
+static void arena_free (struct arena *);
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
 
 /* Initializes the malloc() descriptors. */
 void
 malloc_init (void) {
-	size_t block_size;
+	size_t block_size = 16;
+	char name[24];
 
-	for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2) {
+	for (;;) {
 		struct desc *d = &descs[desc_cnt++];
 		ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
 		d->block_size = block_size;
-		d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
+		d->arena_pages = block_size <= SMALL_MAX ? 1 : MEDIUM_ARENA_PAGES;
+		d->blocks_per_arena = (PGSIZE * d->arena_pages - sizeof (struct arena))
+			/ block_size;
+		d->mag_cap = d->arena_pages > 1 ? 0
+			: MAG_BYTES / block_size < MAG_SIZE ? MAG_BYTES / block_size : MAG_SIZE;
 		list_init (&d->free_list);
 		lock_init (&d->lock);
+		snprintf (name, sizeof name, "malloc %zu", block_size);
+		lock_set_name (&d->lock, name);
+
+		if (block_size == MEDIUM_MAX)
+			break;
+		block_size = ROUND_UP (block_size * 5 / 4, 16);
+		if (block_size > MEDIUM_MAX)
+			block_size = MEDIUM_MAX;
 	}
 }
 
@@ -84,8 +173,10 @@ malloc_init (void) {
 void *
 malloc (size_t size) {
 	struct desc *d;
+	struct magazine *m;
 	struct block *b;
 	struct arena *a;
+	enum intr_level old_level;
 
 	/* A null pointer satisfies a request for 0 bytes. */
 	if (size == 0)
@@ -93,10 +184,8 @@ malloc (size_t size) {
 
 	/* Find the smallest descriptor that satisfies a SIZE-byte
 	   request. */
-	for (d = descs; d < descs + desc_cnt; d++)
-		if (d->block_size >= size)
-			break;
-	if (d == descs + desc_cnt) {
+	d = desc_for_size (size);
+	if (d == NULL) {
 		/* SIZE is too big for any descriptor.
 		   Allocate enough pages to hold SIZE plus an arena. */
 		size_t page_cnt = DIV_ROUND_UP (size + sizeof *a, PGSIZE);
@@ -109,38 +198,26 @@ malloc (size_t size) {
 		a->magic = ARENA_MAGIC;
 		a->desc = NULL;
 		a->free_cnt = page_cnt;
+		atomic_inc (&big_alloc_cnt);
+		atomic_fetch_add (&big_pages, page_cnt);
 		return a + 1;
 	}
 
-	lock_acquire (&d->lock);
-
-	/* If the free list is empty, create a new arena. */
-	if (list_empty (&d->free_list)) {
-		size_t i;
-
-		/* Allocate a page. */
-		a = palloc_get_page (0);
-		if (a == NULL) {
-			lock_release (&d->lock);
-			return NULL;
-		}
-
-		/* Initialize arena and add its blocks to the free list. */
-		a->magic = ARENA_MAGIC;
-		a->desc = d;
-		a->free_cnt = d->blocks_per_arena;
-		for (i = 0; i < d->blocks_per_arena; i++) {
-			struct block *b = arena_to_block (a, i);
-			list_push_back (&d->free_list, &b->free_elem);
-		}
+	/* Take the most recently freed block from the magazine, or
+	   refill it from the free list if it is empty. */
+	m = &magazines[d - descs];
+	old_level = intr_disable ();
+	d->alloc_cnt++;
+	d->req_bytes += size;
+	if (m->cnt > 0) {
+		b = m->blocks[--m->cnt];
+		d->mag_hits++;
+		intr_set_level (old_level);
+		return b;
 	}
+	intr_set_level (old_level);
 
-	/* Get a block from free list and return it. */
-	b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-	a = block_to_arena (b);
-	a->free_cnt--;
-	lock_release (&d->lock);
-	return b;
+	return magazine_refill (d);
 }
 
 /* Allocates and return A times B bytes initialized to zeroes.
@@ -185,7 +262,35 @@ realloc (void *old_block, size_t new_size) {
 		free (old_block);
 		return NULL;
 	} else {
-		void *new_block = malloc (new_size);
+		void *new_block;
+
+		if (old_block != NULL) {
+			struct arena *a = block_to_arena (old_block);
+			struct desc *d = a->desc;
+
+			if (d != NULL) {
+				/* Stay put if NEW_SIZE fits and would not leave
+				   most of the block unused. */
+				if (new_size <= d->block_size
+						&& (d == descs || new_size > d->block_size / 2))
+					return old_block;
+			} else {
+				/* A big block that is big enough keeps its place,
+				   giving back the pages it no longer needs. */
+				size_t page_cnt = DIV_ROUND_UP (new_size + sizeof *a, PGSIZE);
+
+				if (page_cnt <= a->free_cnt) {
+					palloc_free_multiple ((uint8_t *) a + PGSIZE * page_cnt,
+							a->free_cnt - page_cnt);
+					atomic_fetch_add (&big_pages,
+							-(int64_t) (a->free_cnt - page_cnt));
+					a->free_cnt = page_cnt;
+					return old_block;
+				}
+			}
+		}
+
+		new_block = malloc (new_size);
 		if (old_block != NULL && new_block != NULL) {
 			size_t old_size = block_size (old_block);
 			size_t min_size = new_size < old_size ? new_size : old_size;
@@ -208,41 +313,264 @@ free (void *p) {
 		if (d != NULL) {
 			/* It's a normal block.  We handle it here. */
 
+			struct magazine *m = &magazines[d - descs];
+			enum intr_level old_level;
+
 #ifndef NDEBUG
 			/* Clear the block to help detect use-after-free bugs. */
 			memset (b, 0xcc, d->block_size);
 #endif
 
-			lock_acquire (&d->lock);
-
-			/* Add block to free list. */
-			list_push_front (&d->free_list, &b->free_elem);
-
-			/* If the arena is now entirely unused, free it. */
-			if (++a->free_cnt >= d->blocks_per_arena) {
-				size_t i;
-
-				ASSERT (a->free_cnt == d->blocks_per_arena);
-				for (i = 0; i < d->blocks_per_arena; i++) {
-					struct block *b = arena_to_block (a, i);
-					list_remove (&b->free_elem);
-				}
-				palloc_free_page (a);
+			/* Put the block in the magazine, or make room for it
+			   there if it is full. */
+			old_level = intr_disable ();
+			if (m->cnt < d->mag_cap) {
+				m->blocks[m->cnt++] = b;
+				intr_set_level (old_level);
+				return;
 			}
+			intr_set_level (old_level);
 
-			lock_release (&d->lock);
+			magazine_drain (d, b);
 		} else {
 			/* It's a big block.  Free its pages. */
+			atomic_fetch_add (&big_pages, -(int64_t) a->free_cnt);
 			palloc_free_multiple (a, a->free_cnt);
 			return;
 		}
 	}
 }
-
+
+/* Prints, for each size class that has been used, how many
+   blocks it has handed out, how much of each block its requests
+   used on average, and how full its arenas are. */
+void
+malloc_print_stats (void) {
+	struct desc *d;
+
+	for (d = descs; d < descs + desc_cnt; d++) {
+		struct magazine *m = &magazines[d - descs];
+		enum intr_level old_level;
+		int64_t alloc_cnt, req_bytes, mag_hits;
+		size_t arena_bytes, in_use;
+
+		lock_acquire (&d->lock);
+		old_level = intr_disable ();
+		alloc_cnt = d->alloc_cnt;
+		req_bytes = d->req_bytes;
+		mag_hits = d->mag_hits;
+		in_use = d->in_use - m->cnt;
+		intr_set_level (old_level);
+		arena_bytes = d->arena_cnt * d->arena_pages * PGSIZE;
+		lock_release (&d->lock);
+
+		if (alloc_cnt == 0)
+			continue;
+		printf ("Malloc %zu: %lld allocs averaging %lld bytes "
+				"(%lld%% lost to rounding, %lld%% from magazine), "
+				"%zu in use in %zu arenas (%zu%% full)\n", d->block_size,
+				alloc_cnt, req_bytes / alloc_cnt,
+				100 - req_bytes / alloc_cnt * 100 / (int64_t) d->block_size,
+				mag_hits * 100 / alloc_cnt, in_use, d->arena_cnt,
+				arena_bytes > 0 ? in_use * d->block_size * 100 / arena_bytes : 0);
+	}
+	printf ("Malloc big: %lld allocs, %lld pages in use\n",
+			atomic_load (&big_alloc_cnt), atomic_load (&big_pages));
+}
+
+/* Returns the smallest descriptor whose blocks hold SIZE bytes,
+   or a null pointer if SIZE needs a big block. */
+static struct desc *
+desc_for_size (size_t size) {
+	size_t lo = 0, hi = desc_cnt;
+
+	/* Binary search for the first class at least SIZE bytes. */
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+
+		if (descs[mid].block_size < size)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo < desc_cnt ? &descs[lo] : NULL;
+}
+
+/* Adds a new arena's blocks to D's free list.  Returns false if
+   no memory is available.  D's lock must be held. */
+static bool
+desc_grow (struct desc *d) {
+	struct arena *a = arena_alloc (d);
+	size_t i;
+
+	if (a == NULL)
+		return false;
+
+	/* Initialize arena and add its blocks to the free list. */
+	a->magic = ARENA_MAGIC;
+	a->desc = d;
+	a->free_cnt = d->blocks_per_arena;
+	for (i = 0; i < d->blocks_per_arena; i++) {
+		struct block *b = arena_to_block (a, i);
+		list_push_back (&d->free_list, &b->free_elem);
+	}
+	d->arena_cnt++;
+	return true;
+}
+
+/* Returns block B to D's free list, and its arena to the page
+   allocator if that leaves the arena entirely unused.  D's lock
+   must be held. */
+static void
+desc_put (struct desc *d, struct block *b) {
+	struct arena *a = block_to_arena (b);
+
+	/* Add block to free list. */
+	list_push_front (&d->free_list, &b->free_elem);
+	d->in_use--;
+
+	/* If the arena is now entirely unused, free it. */
+	if (++a->free_cnt >= d->blocks_per_arena) {
+		size_t i;
+
+		ASSERT (a->free_cnt == d->blocks_per_arena);
+		for (i = 0; i < d->blocks_per_arena; i++) {
+			struct block *b = arena_to_block (a, i);
+			list_remove (&b->free_elem);
+		}
+		arena_free (a);
+		d->arena_cnt--;
+	}
+}
+
+/* Takes up to half a magazine plus one blocks off D's free list,
+   growing it if it is empty, returns one and puts the rest in D's
+   magazine.  Returns a null pointer if no memory is available. */
+static struct block *
+magazine_refill (struct desc *d) {
+	struct magazine *m = &magazines[d - descs];
+	struct block *batch[MAG_SIZE / 2 + 1];
+	size_t batch_cnt = (d->mag_cap + 1) / 2 + 1;
+	enum intr_level old_level;
+	size_t cnt = 0, i;
+
+	lock_acquire (&d->lock);
+	if (list_empty (&d->free_list) && !desc_grow (d)) {
+		lock_release (&d->lock);
+		return NULL;
+	}
+	while (cnt < batch_cnt && !list_empty (&d->free_list)) {
+		struct block *b = list_entry (list_pop_front (&d->free_list),
+				struct block, free_elem);
+		block_to_arena (b)->free_cnt--;
+		batch[cnt++] = b;
+	}
+	d->in_use += cnt;
+
+	/* Other threads may have freed into the magazine since it was
+	   found empty; whatever no longer fits goes back. */
+	old_level = intr_disable ();
+	for (i = 1; i < cnt && m->cnt < d->mag_cap; i++)
+		m->blocks[m->cnt++] = batch[i];
+	intr_set_level (old_level);
+	for (; i < cnt; i++)
+		desc_put (d, batch[i]);
+
+	lock_release (&d->lock);
+	return batch[0];
+}
+
+/* Returns the least recently freed half of D's magazine to the
+   free list and puts B, which is being freed, in the space that
+   leaves.  With no magazine, just returns B to the free list. */
+static void
+magazine_drain (struct desc *d, struct block *b) {
+	struct magazine *m = &magazines[d - descs];
+	struct block *batch[MAG_SIZE / 2];
+	size_t batch_cnt = (d->mag_cap + 1) / 2;
+	enum intr_level old_level;
+	size_t cnt, i;
+
+	lock_acquire (&d->lock);
+
+	old_level = intr_disable ();
+	cnt = m->cnt < batch_cnt ? m->cnt : batch_cnt;
+	memcpy (batch, m->blocks, sizeof *batch * cnt);
+	memmove (m->blocks, m->blocks + cnt, sizeof *m->blocks * (m->cnt - cnt));
+	m->cnt -= cnt;
+	if (m->cnt < d->mag_cap) {
+		m->blocks[m->cnt++] = b;
+		b = NULL;
+	}
+	intr_set_level (old_level);
+
+	for (i = 0; i < cnt; i++)
+		desc_put (d, batch[i]);
+	if (b != NULL)
+		desc_put (d, b);
+
+	lock_release (&d->lock);
+}
+
+/* Obtains the pages for a new arena of D, or returns a null
+   pointer if they are not available. */
+static struct arena *
+arena_alloc (struct desc *d) {
+	enum intr_level old_level;
+	uint8_t *pages, *a;
+	size_t lead, chunk;
+
+	if (d->arena_pages == 1)
+		return palloc_get_page (0);
+
+	/* Get enough pages to contain an aligned medium arena and give
+	   back the ones before and after it. */
+	pages = palloc_get_multiple (0, 2 * MEDIUM_ARENA_PAGES - 1);
+	if (pages == NULL)
+		return NULL;
+	a = ptov (ROUND_UP (vtop (pages), MEDIUM_ARENA_SIZE));
+	lead = (a - pages) / PGSIZE;
+	palloc_free_multiple (pages, lead);
+	palloc_free_multiple (a + MEDIUM_ARENA_SIZE, MEDIUM_ARENA_PAGES - 1 - lead);
+
+	chunk = vtop (a) / MEDIUM_ARENA_SIZE;
+	if (chunk >= MEDIUM_MAP_BITS) {
+		palloc_free_multiple (a, MEDIUM_ARENA_PAGES);
+		return NULL;
+	}
+	old_level = intr_disable ();
+	medium_map[chunk / 64] |= 1ULL << (chunk % 64);
+	intr_set_level (old_level);
+	return (struct arena *) a;
+}
+
+/* Returns arena A, which must be empty, to the page allocator. */
+static void
+arena_free (struct arena *a) {
+	if (a->desc->arena_pages == 1)
+		palloc_free_page (a);
+	else {
+		size_t chunk = vtop (a) / MEDIUM_ARENA_SIZE;
+		enum intr_level old_level = intr_disable ();
+
+		medium_map[chunk / 64] &= ~(1ULL << (chunk % 64));
+		intr_set_level (old_level);
+		a->magic = 0;
+		palloc_free_multiple (a, MEDIUM_ARENA_PAGES);
+	}
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b) {
-	struct arena *a = pg_round_down (b);
+	uint64_t chunk = vtop (b) / MEDIUM_ARENA_SIZE;
+	struct arena *a;
+
+	if (chunk < MEDIUM_MAP_BITS
+			&& (medium_map[chunk / 64] & (1ULL << (chunk % 64))) != 0)
+		a = ptov (chunk * MEDIUM_ARENA_SIZE);
+	else
+		a = pg_round_down (b);
 
 	/* Check that the arena is valid. */
 	ASSERT (a != NULL);
@@ -250,7 +578,7 @@ block_to_arena (struct block *b) {
 
 	/* Check that the block is properly aligned for the arena. */
 	ASSERT (a->desc == NULL
-			|| (pg_ofs (b) - sizeof *a) % a->desc->block_size == 0);
+			|| ((uint8_t *) b - (uint8_t *) (a + 1)) % a->desc->block_size == 0);
 	ASSERT (a->desc != NULL || pg_ofs (b) == sizeof *a);
 
 	return a;
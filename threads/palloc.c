@@ -2,14 +2,15 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
-#include "threads/synch.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -24,13 +25,55 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Within a pool, free pages are managed by a binary buddy
+   allocator.  Free memory is kept as blocks of 2**K pages, each
+   aligned to its size relative to the pool base, on one free
+   list per order K.  An allocation takes a block from the
+   smallest nonempty order that fits, splitting it in halves as
+   needed, and returns the pages past the request to the free
+   lists.  A freed block merges with its buddy, the other half of
+   the block it was split from, for as long as the buddy is free.
+   Both are O(log n) in the pool size.  The list elements live in
+   the free pages themselves.
+
+   Each pool also has a stack of up to ZEROED_PAGES pages that
+   the idle thread has already filled with zeros, a chunk at a time
+   with interrupts on (see palloc_zero_step()).  Single-page
+   PAL_ZERO requests take from it before clearing a page of their
+   own, and any request falls back on it when the pool is out of
+   free pages.  Only the kernel pool's stack is refilled: user
+   frames are not requested with PAL_ZERO.
+
+   Pool state is accessed with interrupts off rather than under a
+   lock, because thread pages are freed from inside the scheduler,
+   where sleeping is not allowed. */
+
+/* Orders 0 through PALLOC_ORDERS - 1 are tracked, so the largest
+   block is 2**(PALLOC_ORDERS - 1) pages. */
+#define PALLOC_ORDERS 20
+
+/* Pre-zeroed pages kept per pool, and bytes cleared per step. */
+#define ZEROED_PAGES 32
+#define ZERO_CHUNK 512
 
 /* A memory pool. */
 struct pool {
-	struct lock lock;               /* Mutual exclusion. */
+	const char *name;               /* "kernel" or "user". */
 	struct bitmap *used_map;        /* Bitmap of free pages. */
 	uint8_t *base;                  /* Base of pool. */
+	uint8_t *free_order;            /* Per page: 1 + K if the page heads a
+	                                   free block of order K, otherwise 0. */
+	struct list free_lists[PALLOC_ORDERS];  /* Free blocks by order. */
+	size_t free_cnt[PALLOC_ORDERS]; /* Length of each free list. */
+	uint32_t free_mask;             /* Bit K set if free_lists[K] nonempty. */
+	size_t free_pages;              /* Total free pages. */
+
+	void *zeroed[ZEROED_PAGES];     /* Pre-zeroed pages, allocated. */
+	size_t zeroed_cnt;              /* Number of pre-zeroed pages. */
+	int64_t zero_hits;              /* PAL_ZERO pages taken from ZEROED. */
+	int64_t zero_misses;            /* PAL_ZERO pages cleared on demand. */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -42,6 +85,9 @@ static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool (const struct pool *, void *page);
+static size_t buddy_alloc (struct pool *, int order);
+static void buddy_free (struct pool *, size_t page_idx, int order);
+static void pool_free_range (struct pool *, size_t page_idx, size_t page_cnt);
 
 /* multiboot info */
 struct multiboot_info {
@@ -189,6 +235,8 @@ populate_pools (struct area *base_mem, struct area *ext_mem) {
 
 	// generate the user pool
 	init_pool(&user_pool, &free_start, region_start, end);
+	kernel_pool.name = "kernel";
+	user_pool.name = "user";
 
 	// Iterate over the e820_entry. Setup the usable.
 	uint64_t usable_bound = (uint64_t) free_start;
@@ -223,12 +271,12 @@ split:
 			page_idx = pg_no (start) - pg_no (pool->base);
 			if ((uint64_t) pool_end < end) {
 				page_cnt = ((uint64_t) pool_end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				pool_free_range (pool, page_idx, page_cnt);
 				start = (uint64_t) pool_end;
 				goto split;
 			} else {
 				page_cnt = ((uint64_t) end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				pool_free_range (pool, page_idx, page_cnt);
 			}
 		}
 	}
@@ -262,19 +310,43 @@ palloc_init (void) {
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
-
-	lock_acquire (&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-	lock_release (&pool->lock);
-	void *pages;
-
-	if (page_idx != BITMAP_ERROR)
+	size_t page_idx = BITMAP_ERROR;
+	enum intr_level old_level;
+	bool zeroed = false;
+	int order = 0;
+	void *pages = NULL;
+
+	/* Take the smallest block that holds PAGE_CNT pages and give
+	   the pages past PAGE_CNT back to the free lists. */
+	while (((size_t) 1 << order) < page_cnt)
+		order++;
+	old_level = intr_disable ();
+	if (page_cnt == 1 && (flags & PAL_ZERO)) {
+		if (pool->zeroed_cnt > 0) {
+			pages = pool->zeroed[--pool->zeroed_cnt];
+			zeroed = true;
+			pool->zero_hits++;
+		} else
+			pool->zero_misses++;
+	}
+	if (pages == NULL && page_cnt > 0 && order < PALLOC_ORDERS)
+		page_idx = buddy_alloc (pool, order);
+	if (page_idx != BITMAP_ERROR) {
+		ASSERT (bitmap_none (pool->used_map, page_idx, page_cnt));
+		bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+		pool->free_pages -= (size_t) 1 << order;
+		pool_free_range (pool, page_idx + page_cnt,
+				((size_t) 1 << order) - page_cnt);
 		pages = pool->base + PGSIZE * page_idx;
-	else
-		pages = NULL;
+	} else if (pages == NULL && page_cnt == 1 && pool->zeroed_cnt > 0) {
+		/* Out of free pages: give up a pre-zeroed one. */
+		pages = pool->zeroed[--pool->zeroed_cnt];
+		zeroed = true;
+	}
+	intr_set_level (old_level);
 
 	if (pages) {
-		if (flags & PAL_ZERO)
+		if ((flags & PAL_ZERO) && !zeroed)
 			memset (pages, 0, PGSIZE * page_cnt);
 	} else {
 		if (flags & PAL_ASSERT)
@@ -301,6 +373,7 @@ void
 palloc_free_multiple (void *pages, size_t page_cnt) {
 	struct pool *pool;
 	size_t page_idx;
+	enum intr_level old_level;
 
 	ASSERT (pg_ofs (pages) == 0);
 	if (pages == NULL || page_cnt == 0)
@@ -318,8 +391,10 @@ palloc_free_multiple (void *pages, size_t page_cnt) {
 #ifndef NDEBUG
 	memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
+	old_level = intr_disable ();
 	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	pool_free_range (pool, page_idx, page_cnt);
+	intr_set_level (old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -328,18 +403,73 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
+/* Clears the next ZERO_CHUNK bytes of a page bound for the kernel
+   pool's pre-zeroed stack, taking a new page first if none is
+   under way.  Returns false, doing nothing, if the stack is full
+   or the pool is short of free pages.  Called by the idle thread
+   with interrupts on; a page being cleared belongs to no one
+   else, so it may be preempted at any point. */
+bool
+palloc_zero_step (void) {
+	static uint8_t *page;       /* Page being cleared, if any. */
+	static size_t ofs;          /* Bytes of PAGE cleared so far. */
+	struct pool *pool = &kernel_pool;
+	enum intr_level old_level;
+
+	if (page == NULL) {
+		size_t page_idx;
+
+		/* Leave the pool alone once few of its pages are free. */
+		old_level = intr_disable ();
+		if (pool->zeroed_cnt < ZEROED_PAGES
+				&& pool->free_pages > 4 * ZEROED_PAGES
+				&& (page_idx = buddy_alloc (pool, 0)) != BITMAP_ERROR) {
+			bitmap_mark (pool->used_map, page_idx);
+			pool->free_pages--;
+			page = pool->base + PGSIZE * page_idx;
+		}
+		intr_set_level (old_level);
+		if (page == NULL)
+			return false;
+		ofs = 0;
+	}
+
+	memset (page + ofs, 0, ZERO_CHUNK);
+	ofs += ZERO_CHUNK;
+	if (ofs == PGSIZE) {
+		old_level = intr_disable ();
+		if (pool->zeroed_cnt < ZEROED_PAGES)
+			pool->zeroed[pool->zeroed_cnt++] = page;
+		else
+			pool_free_range (pool, pg_no (page) - pg_no (pool->base), 1);
+		intr_set_level (old_level);
+		page = NULL;
+	}
+	return true;
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
   /* We'll put the pool's used_map at its base.
      Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
+     and subtract it from the pool's size.
+     The buddy allocator's per-page free_order array follows it. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
-	size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (pgcnt), PGSIZE) * PGSIZE;
+	size_t bm_size = bitmap_buf_size (pgcnt);
+	size_t bm_pages = DIV_ROUND_UP (bm_size + pgcnt, PGSIZE) * PGSIZE;
+	int order;
 
-	lock_init(&p->lock);
-	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_pages);
+	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_size);
 	p->base = (void *) start;
+	p->free_order = (uint8_t *) *bm_base + bm_size;
+	memset (p->free_order, 0, pgcnt);
+	for (order = 0; order < PALLOC_ORDERS; order++) {
+		list_init (&p->free_lists[order]);
+		p->free_cnt[order] = 0;
+	}
+	p->free_mask = 0;
+	p->free_pages = 0;
 
 	// Mark all to unusable.
 	bitmap_set_all(p->used_map, true);
@@ -347,6 +477,143 @@ init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
 	*bm_base += bm_pages;
 }
 
+/* Returns the free list element stored in the page at PAGE_IDX
+   of pool P. */
+static inline struct list_elem *
+block_elem (struct pool *p, size_t page_idx) {
+	return (struct list_elem *) (p->base + PGSIZE * page_idx);
+}
+
+/* Puts the free block of order ORDER at PAGE_IDX on P's free
+   list. */
+static void
+block_push (struct pool *p, size_t page_idx, int order) {
+	p->free_order[page_idx] = order + 1;
+	list_push_front (&p->free_lists[order], block_elem (p, page_idx));
+	p->free_cnt[order]++;
+	p->free_mask |= 1u << order;
+}
+
+/* Takes the free block of order ORDER at PAGE_IDX off P's free
+   list. */
+static void
+block_remove (struct pool *p, size_t page_idx, int order) {
+	ASSERT (p->free_order[page_idx] == order + 1);
+
+	p->free_order[page_idx] = 0;
+	list_remove (block_elem (p, page_idx));
+	if (--p->free_cnt[order] == 0)
+		p->free_mask &= ~(1u << order);
+}
+
+/* Removes a block of 2**ORDER pages from P's free lists and
+   returns its page index, or BITMAP_ERROR if no block that large
+   is free.  Interrupts must be off. */
+static size_t
+buddy_alloc (struct pool *p, int order) {
+	uint32_t fits = p->free_mask & ~((1u << order) - 1);
+	size_t page_idx;
+	int k;
+
+	if (fits == 0)
+		return BITMAP_ERROR;
+
+	/* Split the smallest free block that fits, keeping the lower
+	   half and freeing the upper half at each step. */
+	k = __builtin_ctz (fits);
+	page_idx = pg_no (list_front (&p->free_lists[k])) - pg_no (p->base);
+	block_remove (p, page_idx, k);
+	while (k > order) {
+		k--;
+		block_push (p, page_idx + ((size_t) 1 << k), k);
+	}
+	return page_idx;
+}
+
+/* Returns the block of 2**ORDER pages at PAGE_IDX, which must be
+   aligned to its size, to P's free lists, merging it with its
+   buddy for as long as the buddy is free.  Interrupts must be
+   off. */
+static void
+buddy_free (struct pool *p, size_t page_idx, int order) {
+	size_t pool_pages = bitmap_size (p->used_map);
+
+	while (order + 1 < PALLOC_ORDERS) {
+		size_t buddy = page_idx ^ ((size_t) 1 << order);
+
+		if (buddy + ((size_t) 1 << order) > pool_pages
+				|| p->free_order[buddy] != order + 1)
+			break;
+		block_remove (p, buddy, order);
+		page_idx &= ~((size_t) 1 << order);
+		order++;
+	}
+	block_push (p, page_idx, order);
+}
+
+/* Frees the PAGE_CNT pages at PAGE_IDX in P, which need not be a
+   power of 2 or aligned, by splitting them into the largest
+   aligned blocks that fit.  Interrupts must be off. */
+static void
+pool_free_range (struct pool *p, size_t page_idx, size_t page_cnt) {
+	bitmap_set_multiple (p->used_map, page_idx, page_cnt, false);
+	p->free_pages += page_cnt;
+
+	while (page_cnt > 0) {
+		int order = 0;
+
+		while (order + 1 < PALLOC_ORDERS
+				&& (page_idx & ((size_t) 1 << order)) == 0
+				&& ((size_t) 2 << order) <= page_cnt)
+			order++;
+		buddy_free (p, page_idx, order);
+		page_idx += (size_t) 1 << order;
+		page_cnt -= (size_t) 1 << order;
+	}
+}
+
+/* Prints the free block counts of pool P by order and how
+   fragmented its free memory is: the share of free pages that
+   lie outside the largest free block. */
+static void
+pool_print_stats (struct pool *p) {
+	enum intr_level old_level;
+	size_t free_cnt[PALLOC_ORDERS];
+	size_t free_pages, zeroed_cnt;
+	uint32_t free_mask;
+	int64_t zero_hits, zero_cnt;
+	int order, top;
+
+	old_level = intr_disable ();
+	memcpy (free_cnt, p->free_cnt, sizeof free_cnt);
+	free_pages = p->free_pages;
+	free_mask = p->free_mask;
+	zeroed_cnt = p->zeroed_cnt;
+	zero_hits = p->zero_hits;
+	zero_cnt = p->zero_hits + p->zero_misses;
+	intr_set_level (old_level);
+
+	top = free_mask != 0 ? 31 - __builtin_clz (free_mask) : -1;
+	printf ("Palloc: %s pool %zu of %zu pages free, largest block %zu pages, "
+			"%zu%% fragmented\n", p->name, free_pages,
+			bitmap_size (p->used_map), top >= 0 ? (size_t) 1 << top : 0,
+			top >= 0 ? 100 - ((size_t) 100 << top) / free_pages : 0);
+	printf ("Palloc: %s pool free blocks by order:", p->name);
+	for (order = 0; order <= top; order++)
+		printf (" %zu", free_cnt[order]);
+	printf ("\n");
+	printf ("Palloc: %s pool %zu pages pre-zeroed, %lld of %lld PAL_ZERO "
+			"pages served from them (%lld%%)\n", p->name, zeroed_cnt,
+			zero_hits, zero_cnt, zero_cnt > 0 ? zero_hits * 100 / zero_cnt : 0);
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void) {
+	pool_print_stats (&kernel_pool);
+	pool_print_stats (&user_pool);
+}
+
 /* Returns true if PAGE was allocated from POOL,
    false otherwise. */
 static bool
@@ -0,0 +1,233 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Each slab is one page from the kernel pool.  It starts with a
+   struct slab, followed by one free-list link per object, followed
+   by the objects themselves.  Keeping the links outside the
+   objects leaves constructed state intact while an object is
+   free.  A slab is found from any of its objects by rounding the
+   object's address down to a page boundary. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* Marks the end of a slab's free list. */
+#define SLAB_END UINT16_MAX
+
+/* A cache keeps at most this many empty slabs; the rest go back
+   to the page allocator. */
+#define SLAB_EMPTY_MAX 1
+
+/* Slab header. */
+struct slab {
+	unsigned magic;             /* Always set to SLAB_MAGIC. */
+	struct kmem_cache *cache;   /* Owning cache. */
+	struct list_elem elem;      /* Element in one of the cache's lists. */
+	uint16_t in_use;            /* Objects handed out. */
+	uint16_t free;              /* Index of the first free object. */
+	uint16_t next[];            /* Next free object after each free one. */
+};
+
+/* All caches, for statistics. */
+static struct list caches;
+
+static struct slab *slab_create (struct kmem_cache *);
+static struct slab *obj_to_slab (struct kmem_cache *, void *);
+
+/* Returns a pointer to object IDX in slab S. */
+static inline void *
+slab_obj (struct kmem_cache *c, struct slab *s, size_t idx) {
+	return (uint8_t *) s + c->obj_ofs + c->obj_size * idx;
+}
+
+/* Initializes the slab allocator. */
+void
+slab_init (void) {
+	list_init (&caches);
+}
+
+/* Initializes C as a cache of SIZE-byte objects aligned to ALIGN,
+   which must be a power of 2 (0 means pointer alignment).  CTOR,
+   if not null, is run on each object when its slab is created. */
+void
+kmem_cache_init (struct kmem_cache *c, const char *name, size_t size,
+		size_t align, kmem_ctor *ctor) {
+	size_t n;
+
+	ASSERT (c != NULL);
+	ASSERT (size > 0);
+	if (align == 0)
+		align = sizeof (void *);
+	ASSERT ((align & (align - 1)) == 0);
+
+	strlcpy (c->name, name, sizeof c->name);
+	c->align = align;
+	c->obj_size = ROUND_UP (size, align);
+	c->ctor = ctor;
+
+	/* Fit as many objects as possible after the header and its
+	   links, then place the first object at the next multiple of
+	   ALIGN. */
+	n = (PGSIZE - sizeof (struct slab)) / (c->obj_size + sizeof (uint16_t));
+	while (n > 0 && ROUND_UP (sizeof (struct slab) + n * sizeof (uint16_t),
+				align) + n * c->obj_size > PGSIZE)
+		n--;
+	ASSERT (n > 0 && n < SLAB_END);
+	c->objs_per_slab = n;
+	c->obj_ofs = ROUND_UP (sizeof (struct slab) + n * sizeof (uint16_t), align);
+
+	lock_init (&c->lock);
+	lock_set_name (&c->lock, c->name);
+	list_init (&c->partial);
+	list_init (&c->full);
+	list_init (&c->empty);
+	c->empty_cnt = c->slab_cnt = c->in_use = 0;
+	c->allocs = c->frees = c->slabs_created = 0;
+
+	list_push_back (&caches, &c->elem);
+}
+
+/* Returns an object from cache C, or a null pointer if no memory
+   is available. */
+void *
+kmem_cache_alloc (struct kmem_cache *c) {
+	struct slab *s;
+	void *obj;
+
+	lock_acquire (&c->lock);
+
+	/* Fill partial slabs first, then reuse an empty one, and only
+	   then take a new page. */
+	if (!list_empty (&c->partial))
+		s = list_entry (list_front (&c->partial), struct slab, elem);
+	else if (!list_empty (&c->empty)) {
+		s = list_entry (list_pop_front (&c->empty), struct slab, elem);
+		c->empty_cnt--;
+		list_push_front (&c->partial, &s->elem);
+	} else {
+		s = slab_create (c);
+		if (s == NULL) {
+			lock_release (&c->lock);
+			return NULL;
+		}
+		list_push_front (&c->partial, &s->elem);
+	}
+
+	ASSERT (s->free != SLAB_END);
+	obj = slab_obj (c, s, s->free);
+	s->free = s->next[s->free];
+	if (++s->in_use == c->objs_per_slab) {
+		list_remove (&s->elem);
+		list_push_back (&c->full, &s->elem);
+	}
+	c->in_use++;
+	c->allocs++;
+
+	lock_release (&c->lock);
+	return obj;
+}
+
+/* Returns OBJ, which must have come from cache C, to C.  OBJ may
+   be a null pointer. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj) {
+	struct slab *s;
+	size_t idx;
+
+	if (obj == NULL)
+		return;
+
+	s = obj_to_slab (c, obj);
+	idx = ((uint8_t *) obj - (uint8_t *) slab_obj (c, s, 0)) / c->obj_size;
+
+	lock_acquire (&c->lock);
+	ASSERT (s->in_use > 0);
+
+	if (s->in_use-- == c->objs_per_slab) {
+		list_remove (&s->elem);
+		list_push_front (&c->partial, &s->elem);
+	}
+	s->next[idx] = s->free;
+	s->free = idx;
+	c->in_use--;
+	c->frees++;
+
+	/* Keep a few empty slabs to absorb alloc/free churn, and give
+	   the rest back. */
+	if (s->in_use == 0) {
+		list_remove (&s->elem);
+		if (c->empty_cnt < SLAB_EMPTY_MAX) {
+			list_push_front (&c->empty, &s->elem);
+			c->empty_cnt++;
+		} else {
+			c->slab_cnt--;
+			s->magic = 0;
+			palloc_free_page (s);
+		}
+	}
+
+	lock_release (&c->lock);
+}
+
+/* Prints statistics for every cache. */
+void
+kmem_cache_print_stats (void) {
+	struct list_elem *e;
+
+	for (e = list_begin (&caches); e != list_end (&caches); e = list_next (e)) {
+		struct kmem_cache *c = list_entry (e, struct kmem_cache, elem);
+
+		printf ("Slab %s: %zu-byte objects, %zu per slab, %zu in use, "
+				"%zu slabs (%zu empty, %lld created), %lld allocs, %lld frees\n",
+				c->name, c->obj_size, c->objs_per_slab, c->in_use,
+				c->slab_cnt, c->empty_cnt, c->slabs_created, c->allocs,
+				c->frees);
+	}
+}
+
+/* Takes a page from the kernel pool and makes it an empty slab
+   of cache C, running C's constructor on each object.  Returns
+   the slab, or a null pointer if no page is available.  C's lock
+   must be held. */
+static struct slab *
+slab_create (struct kmem_cache *c) {
+	struct slab *s = palloc_get_page (0);
+	size_t i;
+
+	if (s == NULL)
+		return NULL;
+
+	s->magic = SLAB_MAGIC;
+	s->cache = c;
+	s->in_use = 0;
+	s->free = 0;
+	for (i = 0; i < c->objs_per_slab; i++) {
+		s->next[i] = i + 1 < c->objs_per_slab ? i + 1 : SLAB_END;
+		if (c->ctor != NULL)
+			c->ctor (slab_obj (c, s, i));
+	}
+	c->slab_cnt++;
+	c->slabs_created++;
+	return s;
+}
+
+/* Returns the slab of cache C that OBJ is in. */
+static struct slab *
+obj_to_slab (struct kmem_cache *c, void *obj) {
+	struct slab *s = pg_round_down (obj);
+
+	/* Check that the slab is valid. */
+	ASSERT (s->magic == SLAB_MAGIC);
+	ASSERT (s->cache == c);
+
+	/* Check that the object is properly aligned for the slab. */
+	ASSERT (pg_ofs (obj) >= c->obj_ofs);
+	ASSERT ((pg_ofs (obj) - c->obj_ofs) % c->obj_size == 0);
+
+	return s;
+}
@@ -31,6 +31,34 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "devices/timer.h"
+
+static bool waiter_less (const struct heap_elem *, const struct heap_elem *,
+		void *aux);
+
+/* Lock profiler (-lockprof).  Named locks and rwlocks each get a
+   slot in a fixed table, so locks can be named before malloc() is
+   up. */
+#define LOCK_STAT_MAX 64
+
+bool lock_profile;
+
+static struct lock_stat lock_stats[LOCK_STAT_MAX];
+static size_t lock_stat_cnt;
+static int lock_stat_dropped;     /* Names that did not fit. */
+
+static struct lock_stat *lock_stat_alloc (const char *name);
+static void lock_stat_acquired (struct lock_stat *, uint64_t wait_start,
+		bool contended, uint64_t *since);
+static void lock_stat_released (struct lock_stat *, uint64_t since);
+
+/* Levels of nested priority donation followed, through both
+   locks and rwlocks. */
+#define DONATION_DEPTH 8
+
+/* Next wait sequence number.  Waiters of equal priority are woken
+   in the order they started waiting. */
+static uint64_t next_wait_seq;
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -46,7 +74,7 @@ sema_init (struct semaphore *sema, unsigned value) {
 	ASSERT (sema != NULL);
 
 	sema->value = value;
-	list_init (&sema->waiters);
+	heap_init (&sema->waiters, waiter_less, NULL);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -72,10 +100,12 @@ void sema_down (struct semaphore *sema)
 	// 세마포어 값이 0이면
 	while (sema->value == 0) 
 	{
-		// waiters 리스트 뒤에 삽입
-		// list_push_back (&sema->waiters, &thread_current ()->elem);
+		struct thread *cur = thread_current();
 
-		list_insert_ordered(&sema->waiters, &thread_current()->elem, cmp_priority, NULL);  // +
+		// 우선순위 힙에 삽입 (O(1)), 같은 우선순위끼리는 먼저 온 순서
+		cur->wait_heap = &sema->waiters;
+		cur->wait_seq = next_wait_seq++;
+		heap_push(&sema->waiters, &cur->wait_elem);
 		// 현재 스레드를 block 상태로 전환
     
 		thread_block ();
@@ -127,10 +157,13 @@ void sema_up (struct semaphore *sema)
 
 	old_level = intr_disable (); // 인터럽트 비활성화
 
-	if (!list_empty (&sema->waiters)) // 대기중인 스레드가 있다면
+	if (!heap_empty (&sema->waiters)) // 대기중인 스레드가 있다면
 	{
-		list_sort(&sema->waiters, cmp_priority, NULL); // ++ 리스트 재정렬
-		thread_unblock (list_entry (list_pop_front (&sema->waiters), struct thread, elem)); // 리스트의 가장 앞 부분 스레드 깨움
+		// 힙의 루트가 우선순위가 가장 높은 스레드 (O(log n))
+		struct thread *t = heap_entry (heap_pop (&sema->waiters), struct thread, wait_elem);
+
+		t->wait_heap = NULL;
+		thread_unblock (t);
 	}
 
 	sema->value++; // 세마포어 값을 증가시켜 자원 해제
@@ -138,8 +171,42 @@ void sema_up (struct semaphore *sema)
 	intr_set_level (old_level); // 인터럽트 활성화
 }
 
+/// @brief 세마포어나 rwlock을 기다리는 스레드 T의 우선순위가 바뀐 뒤 대기자 힙에서 위치를 고침
+/// @param t 우선순위가 바뀐 대기 스레드
+/// @param old_priority 바뀌기 전 우선순위
+void waiter_reprioritize (struct thread *t, int old_priority)
+{
+	struct heap *waiters = t->wait_heap;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (t->priority > old_priority)
+		heap_increase (waiters, &t->wait_elem);
+	else if (t->priority < old_priority)
+	{
+		heap_remove (waiters, &t->wait_elem);
+		heap_push (waiters, &t->wait_elem);
+	}
+}
+
+/// @brief 대기자 힙의 비교 함수: 우선순위가 낮거나, 같으면 나중에 온 스레드가 작음
+static bool waiter_less (const struct heap_elem *a_, const struct heap_elem *b_,
+		void *aux UNUSED)
+{
+	const struct thread *a = heap_entry (a_, struct thread, wait_elem);
+	const struct thread *b = heap_entry (b_, struct thread, wait_elem);
+
+	if (a->priority != b->priority)
+		return a->priority < b->priority;
+	return a->wait_seq > b->wait_seq;
+}
 
 static void sema_test_helper (void *sema_);
+static void lock_take (struct lock *);
+static void donate_chain (struct thread *, int depth);
+static int rwlock_waiter_priority (const struct rwlock *);
+static void rwlock_donate (struct rwlock *, struct thread *, int depth);
+static struct rwlock_hold *rwlock_hold_find (struct thread *, const struct rwlock *);
 
 /* Self-test for semaphores that makes control "ping-pong"
    between a pair of threads.  Insert calls to printf() to see
@@ -195,6 +262,16 @@ lock_init (struct lock *lock) {
 
 	lock->holder = NULL;
 	sema_init (&lock->semaphore, 1);
+	lock->max_priority = PRI_MIN - 1;
+	lock->stat = NULL;
+}
+
+/* Names LOCK and registers it with the lock profiler. */
+void
+lock_set_name (struct lock *lock, const char *name) {
+	ASSERT (lock != NULL);
+
+	lock->stat = lock_stat_alloc (name);
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -215,44 +292,113 @@ void lock_acquire (struct lock *lock)
 	ASSERT (!lock_held_by_current_thread (lock));
 
 	struct thread *cur_thread = thread_current();
-
-	if (lock->holder) // 락을 즉시 획득할 수 없다면 (이미 다른 스레드가 보유 중이라면)
+	enum intr_level old_level;
+	bool profiled = lock->stat != NULL && lock_profile;
+	bool contended = false;
+	uint64_t wait_start = 0;
+
+	// 락을 즉시 획득할 수 없다면 (이미 다른 스레드가 보유 중이라면)
+	// 4.4BSD 스케줄러에서는 우선순위 기부를 하지 않음
+	old_level = intr_disable();
+	if (profiled)
+	{
+		contended = lock->semaphore.value == 0;
+		wait_start = timer_now_ns();
+	}
+	if (lock->holder && !thread_mlfqs)
 	{
 		// 현재 스레드가 기다리고 있는 락 저장 
 		cur_thread->waiting_lock = lock; 
-		// 락의 소유자에게 우선순위 기부: donations 리스트에 현재 스레드를 삽입
-		list_insert_ordered(&lock->holder->donations, &cur_thread->donation_elem, thread_cmp_donate_priority, NULL); 
-		// 현재 락의 holder에게 우선순위 기부 
-		// lock->holder->priority = cur_thread->priority;
+		// 락의 최고 대기자 우선순위를 올리고 holder 체인을 따라 기부
 		nested_donation();
 	}
+	intr_set_level(old_level);
 
 	// lock의 내부 세마포어를 down하여, lock을 획득할 수 있을 때까지 대기
 	sema_down(&lock->semaphore);
+
+	old_level = intr_disable();
 	// 락 획득 성공 -> 기다리는 락 없음
 	cur_thread->waiting_lock = NULL;
 	// 세마포어 획득 후, 현재 스레드를 lock의 holder로 설정
-	lock->holder = thread_current();
+	lock_take(lock);
+	if (profiled)
+		lock_stat_acquired(lock->stat, wait_start, contended, &lock->stat->held_since);
+	intr_set_level(old_level);
+}
+
+/// @brief 현재 스레드를 LOCK의 holder로 만들고 보유 락 힙에 넣음 (인터럽트 off 상태에서 호출)
+/// @param lock 방금 획득한 락
+static void lock_take (struct lock *lock)
+{
+	struct thread *cur_thread = thread_current();
+	struct heap_elem *top = heap_top(&lock->semaphore.waiters);
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	lock->holder = cur_thread;
+	if (thread_mlfqs)
+		return;
+
+	// 남은 대기자 힙의 루트가 최고 우선순위
+	lock->max_priority = top == NULL ? PRI_MIN - 1
+		: heap_entry(top, struct thread, wait_elem)->priority;
+	heap_push(&cur_thread->held_locks, &lock->elem);
+
+	// 남은 대기자들이 새 holder에게 기부
+	if (lock->max_priority > cur_thread->priority)
+		cur_thread->priority = lock->max_priority;
 }
 
-/// @brief 현재 스레드가 기다리고 있는 락을 따라가며 우선순위를 기부
-/// @param  
+/// @brief 현재 스레드가 기다리고 있는 락을 따라가며 우선순위를 기부 (인터럽트 off 상태에서 호출)
 void nested_donation(void)
 {
-	int depth;
-	struct thread *cur_thread = thread_current(); 
+	donate_chain(thread_current(), DONATION_DEPTH);
+}
+
+/// @brief 스레드 T가 기다리고 있는 락을 따라가며 T의 우선순위를 기부
+///
+/// 각 단계에서 락의 max_priority를 올리고 holder의 보유 락 힙에서 키를 증가시킨 뒤
+/// holder의 우선순위를 갱신하므로, 단계마다 리스트를 다시 훑지 않는다.
+/// rwlock을 기다리는 스레드에 닿으면 그 rwlock의 holder들에게 이어서 기부한다.
+/// 더 올라갈 우선순위가 없으면 바로 멈춘다. (인터럽트 off 상태에서 호출)
+/// @param t 기부를 시작할 스레드
+/// @param depth 남은 중첩 단계 수
+static void donate_chain(struct thread *t, int depth)
+{
+	struct thread *cur_thread = t;
+
+	ASSERT (intr_get_level () == INTR_OFF);
 
-	for (depth = 0; depth < 8; depth++) // 8단계 까지 중첩 기부 허용
+	for (; depth > 0; depth--)
 	{
-		if (!cur_thread->waiting_lock) // 기다리고 있는 락이 없다면
+		struct lock *lock = cur_thread->waiting_lock;
+
+		// rwlock 대기자라면 writer나 reader 전원에게 기부를 넘김
+		if (cur_thread->waiting_rw != NULL)
+		{
+			rwlock_donate(cur_thread->waiting_rw, cur_thread, depth - 1);
+			break;
+		}
+
+		if (!lock || !lock->holder) // 기다리고 있는 락이 없다면
 			break; // 중단
 		
-		// 현재 스레드가 기다리고 있는 락의 holder (우선순위 기부 대상)
-		struct thread *holder = cur_thread->waiting_lock->holder; 	
+		// 락 대기자 중 최고 우선순위가 이미 이 이상이면 더 기부할 것이 없음
+		if (lock->max_priority >= cur_thread->priority)
+			break;
 		
+		// 현재 스레드가 기다리고 있는 락의 holder (우선순위 기부 대상)
+		struct thread *holder = lock->holder; 	
+
+		lock->max_priority = cur_thread->priority;
+		heap_increase(&holder->held_locks, &lock->elem);
+
 		// 기부 대상의 우선순위가 현재 스레드보다 낮다면 기부 
-		if (holder->priority < cur_thread->priority)
-			holder->priority = cur_thread->priority; 
+		// (holder가 준비 상태면 새 우선순위 큐로 옮겨짐)
+		if (holder->priority >= lock->max_priority)
+			break;
+		thread_update_priority(holder, lock->max_priority);
 		
 		// holder가 다른 락을 기다릴 수 있음
 		cur_thread = holder;
@@ -269,12 +415,19 @@ bool lock_try_acquire (struct lock *lock)
 {
 	bool success;
 
+	enum intr_level old_level;
+
 	ASSERT (lock != NULL);
 	ASSERT (!lock_held_by_current_thread (lock));
 
+	old_level = intr_disable ();
 	success = sema_try_down (&lock->semaphore);
-	if (success)
-		lock->holder = thread_current ();
+	if (success) {
+		lock_take (lock);
+		if (lock->stat != NULL && lock_profile)
+			lock_stat_acquired (lock->stat, 0, false, &lock->stat->held_since);
+	}
+	intr_set_level (old_level);
 	return success;
 }
 
@@ -292,49 +445,156 @@ void lock_release (struct lock *lock)
 	ASSERT (lock != NULL);
 	ASSERT (lock_held_by_current_thread (lock));
 
-	struct list_elem *e;
-	struct thread *cur = thread_current();
+	enum intr_level old_level = intr_disable();
 
-	// donations 리스트 순회
-	for (e = list_begin(&cur->donations); e != list_end(&cur->donations); e = list_next(e))
-	{	
-		struct thread *t = list_entry(e, struct thread, donation_elem);
+	if (lock->stat != NULL && lock_profile)
+		lock_stat_released(lock->stat, lock->stat->held_since);
 
-		if (t->waiting_lock == lock) // 락이 있다면
-			list_remove(&t->donation_elem); // 기부 회수
-	}
+	if (!thread_mlfqs)
+	{
+		// 이 락의 대기자들이 준 기부 회수: 보유 락 힙에서 빼고 (O(log n))
+		heap_remove(&thread_current()->held_locks, &lock->elem);
+		lock->max_priority = PRI_MIN - 1;
 
-	multiple_donation(); // 기부 정리
+		multiple_donation(); // 기부 정리
+	}
 
 	lock->holder = NULL; // lock의 소유자를 NULL로 설정
 	sema_up (&lock->semaphore); // lock 내부 세마포어를 up하여 다음 대기 중인 스레드에게 lock을 넘김
+	intr_set_level(old_level);
 }
 
+/// @brief 현재 스레드의 우선순위를 원래 우선순위와 보유 락(rwlock 포함) 대기자의 최고 우선순위 중 큰 값으로 재계산
 void multiple_donation(void)
 {
 	struct thread *cur = thread_current();
+	struct heap_elem *top = heap_top(&cur->held_locks);
+	int i;
+
+	// 기부가 없다면 original 우선순위로 복귀
+	cur->priority = cur->original_priority;
+
+	// 보유 락 힙의 루트가 대기자 우선순위가 가장 높은 락
+	if (top != NULL)
+	{
+		struct lock *lock = heap_entry(top, struct lock, elem);
+
+		if (lock->max_priority > cur->priority)
+			cur->priority = lock->max_priority;
+	}
+
+	// 보유 중인 rwlock들의 대기자도 기부
+	for (i = 0; i < RWLOCK_HOLD_MAX; i++)
+	{
+		int rw_priority;
+
+		if (cur->rw_holds[i].rw == NULL)
+			continue;
+		rw_priority = rwlock_waiter_priority(cur->rw_holds[i].rw);
+		if (rw_priority > cur->priority)
+			cur->priority = rw_priority;
+	}
+}
 
-	// donations 리스트가 비었다면
-	if (list_empty(&cur->donations))
+/// @brief 이름 붙은 락에 프로파일 슬롯을 배정. 슬롯이 모자라면 NULL (프로파일 안 함)
+static struct lock_stat *lock_stat_alloc (const char *name)
+{
+	struct lock_stat *s = NULL;
+	enum intr_level old_level = intr_disable();
+
+	if (lock_stat_cnt < LOCK_STAT_MAX)
 	{
-		// 우선순위 값을 original 우선순위로 복귀
-		cur->priority = cur->original_priority;
+		s = &lock_stats[lock_stat_cnt++];
+		memset(s, 0, sizeof *s);
+		strlcpy(s->name, name, sizeof s->name);
 	}
-	// 비어있지 않다면
-	else if (!list_empty(&cur->donations))
+	else
+		lock_stat_dropped++;
+	intr_set_level(old_level);
+	return s;
+}
+
+/// @brief 획득 한 번을 기록하고 *SINCE에 보유 시작 시각을 남김 (인터럽트 off 상태에서 호출)
+/// @param wait_start 대기를 시작한 시각 (contended일 때만 사용)
+/// @param contended 다른 스레드가 보유 중이어서 기다려야 했는지
+static void lock_stat_acquired (struct lock_stat *s, uint64_t wait_start,
+		bool contended, uint64_t *since)
+{
+	uint64_t now = timer_now_ns();
+
+	s->acquired++;
+	if (contended)
 	{
-		// 정렬 후 맨 앞의 값이 가장 크므로 list_sort -> front->priority 값으로 갱신
-		// donations의 우선순위가 가장 높은 값으로 갱신
-		list_sort(&cur->donations, thread_cmp_donate_priority, NULL);
-		struct thread *front = list_entry(list_front(&cur->donations), struct thread, donation_elem);
-		cur->priority = front->priority;
+		uint64_t wait = now - wait_start;
+
+		s->contended++;
+		s->wait_total += wait;
+		if (wait > s->wait_max)
+			s->wait_max = wait;
+	}
+	*since = now;
+}
+
+/// @brief SINCE부터 이어진 보유 한 번을 기록 (인터럽트 off 상태에서 호출)
+static void lock_stat_released (struct lock_stat *s, uint64_t since)
+{
+	uint64_t hold = timer_now_ns() - since;
+
+	s->hold_total += hold;
+	if (hold > s->hold_max)
+		s->hold_max = hold;
+}
+
+/* Returns the statistics of the lock or rwlock named NAME, or a
+   null pointer if there is none.  The counters keep changing
+   while the kernel runs. */
+const struct lock_stat *
+lock_stat_find (const char *name) {
+	size_t i;
+
+	for (i = 0; i < lock_stat_cnt; i++)
+		if (!strcmp (lock_stats[i].name, name))
+			return &lock_stats[i];
+	return NULL;
+}
+
+/* Prints lock profiler statistics, most total wait time first.
+   Prints nothing unless the kernel ran with -lockprof. */
+void
+lock_print_stats (void) {
+	const struct lock_stat *order[LOCK_STAT_MAX];
+	size_t i, j;
+
+	if (!lock_profile)
+		return;
+
+	for (i = 0; i < lock_stat_cnt; i++)
+		order[i] = &lock_stats[i];
+	for (i = 1; i < lock_stat_cnt; i++)
+		for (j = i; j > 0 && order[j - 1]->wait_total < order[j]->wait_total; j--) {
+			const struct lock_stat *tmp = order[j];
+			order[j] = order[j - 1];
+			order[j - 1] = tmp;
+		}
+
+	printf ("Locks: %zu profiled (%d unnamed for lack of slots), times in us\n",
+			lock_stat_cnt, lock_stat_dropped);
+	for (i = 0; i < lock_stat_cnt; i++) {
+		const struct lock_stat *s = order[i];
+
+		printf ("  %-16s %8lld acq %8lld cont  wait %10llu max %8llu"
+				"  hold %10llu max %8llu\n",
+				s->name, s->acquired, s->contended,
+				s->wait_total / 1000, s->wait_max / 1000,
+				s->hold_total / 1000, s->hold_max / 1000);
 	}
 }
 
-bool thread_cmp_donate_priority (const struct list_elem *a, const struct list_elem *b, void *aux)
+/// @brief 보유 락 힙의 비교 함수: 대기자 최고 우선순위가 낮은 락이 작음
+bool lock_cmp_priority (const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED)
 {
-	return list_entry(a, struct thread, donation_elem)->priority >
-			list_entry(b, struct thread, donation_elem)->priority;
+	return heap_entry(a, struct lock, elem)->max_priority <
+			heap_entry(b, struct lock, elem)->max_priority;
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -347,11 +607,278 @@ lock_held_by_current_thread (const struct lock *lock) {
 	return lock->holder == thread_current ();
 }
 
-/* One semaphore in a list. */
+/* Initializes RW as an rwlock that nobody holds. */
+void
+rwlock_init (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	rw->writer = NULL;
+	rw->readers = 0;
+	list_init (&rw->reader_list);
+	heap_init (&rw->read_waiters, waiter_less, NULL);
+	heap_init (&rw->write_waiters, waiter_less, NULL);
+	rw->stat = NULL;
+}
+
+/* Names RW and registers it with the lock profiler. */
+void
+rwlock_set_name (struct rwlock *rw, const char *name) {
+	ASSERT (rw != NULL);
+
+	rw->stat = lock_stat_alloc (name);
+}
+
+/// @brief RW 대기자 중 최고 우선순위, 대기자가 없으면 PRI_MIN - 1
+static int rwlock_waiter_priority (const struct rwlock *rw)
+{
+	struct heap_elem *r = heap_top(&rw->read_waiters);
+	struct heap_elem *w = heap_top(&rw->write_waiters);
+	int priority = PRI_MIN - 1;
+
+	if (r != NULL)
+		priority = heap_entry(r, struct thread, wait_elem)->priority;
+	if (w != NULL && heap_entry(w, struct thread, wait_elem)->priority > priority)
+		priority = heap_entry(w, struct thread, wait_elem)->priority;
+	return priority;
+}
+
+/// @brief 스레드 T를 RW의 holder로 만들고, 남은 대기자들의 기부를 반영 (인터럽트 off 상태에서 호출)
+/// @param t 새 holder (실행 중이거나, 대기자 힙에서 막 꺼낸 스레드)
+/// @param write 쓰기 모드면 true
+static void rwlock_grant (struct rwlock *rw, struct thread *t, bool write)
+{
+	struct rwlock_hold *hold = rwlock_hold_find(t, NULL);
+	int priority;
+
+	// 빈 칸은 acquire에서 확인했음
+	ASSERT (hold != NULL);
+	hold->rw = rw;
+	if (write)
+		rw->writer = t;
+	else
+	{
+		rw->readers++;
+		list_push_back(&rw->reader_list, &hold->elem);
+	}
+
+	if (thread_mlfqs)
+		return;
+	priority = rwlock_waiter_priority(rw);
+	if (priority > t->priority)
+		t->priority = priority;
+}
+
+/// @brief RW를 기다리는 스레드 T의 우선순위를 RW의 모든 holder에게 기부하고 holder가 기다리는 체인까지 전파
+/// @param depth holder 뒤로 남은 중첩 단계 수
+static void rwlock_donate (struct rwlock *rw, struct thread *t, int depth)
+{
+	struct list_elem *e;
+
+	if (rw->writer != NULL)
+	{
+		if (rw->writer->priority < t->priority)
+		{
+			thread_update_priority(rw->writer, t->priority);
+			donate_chain(rw->writer, depth);
+		}
+		return;
+	}
+
+	for (e = list_begin(&rw->reader_list); e != list_end(&rw->reader_list); e = list_next(e))
+	{
+		struct thread *reader = list_entry(e, struct rwlock_hold, elem)->thread;
+
+		if (reader->priority < t->priority)
+		{
+			thread_update_priority(reader, t->priority);
+			donate_chain(reader, depth);
+		}
+	}
+}
+
+/// @brief 스레드 T가 RW를 잡고 있는 칸, RW가 NULL이면 빈 칸. 없으면 NULL
+static struct rwlock_hold *rwlock_hold_find (struct thread *t, const struct rwlock *rw)
+{
+	int i;
+
+	for (i = 0; i < RWLOCK_HOLD_MAX; i++)
+		if (t->rw_holds[i].rw == rw)
+			return &t->rw_holds[i];
+	return NULL;
+}
+
+/// @brief 현재 스레드를 RW의 WAITERS 힙에 넣고 holder들에게 기부한 뒤 block. 깨어났을 때는 이미 holder가 되어 있음
+static void rwlock_wait (struct rwlock *rw, struct heap *waiters)
+{
+	struct thread *cur = thread_current();
+
+	cur->waiting_rw = rw;
+	cur->wait_heap = waiters;
+	cur->wait_seq = next_wait_seq++;
+	heap_push(waiters, &cur->wait_elem);
+	if (!thread_mlfqs)
+		donate_chain(cur, DONATION_DEPTH);
+	thread_block();
+}
+
+/// @brief RW가 비었으면 다음 holder에게 넘김: 최고 우선순위 writer 한 명, 또는 reader 전부
+static void rwlock_wake (struct rwlock *rw)
+{
+	struct heap_elem *r = heap_top(&rw->read_waiters);
+	struct heap_elem *w = heap_top(&rw->write_waiters);
+
+	if (rw->writer != NULL)
+		return;
+
+	// 동점이면 writer 우선
+	if (w != NULL && (r == NULL || heap_entry(w, struct thread, wait_elem)->priority
+			>= heap_entry(r, struct thread, wait_elem)->priority))
+	{
+		struct thread *t;
+
+		if (rw->readers > 0)
+			return;
+		t = heap_entry(heap_pop(&rw->write_waiters), struct thread, wait_elem);
+		t->wait_heap = NULL;
+		t->waiting_rw = NULL;
+		rwlock_grant(rw, t, true);
+		thread_unblock(t);
+		return;
+	}
+
+	// 대기 중인 reader는 함께 들어감
+	while (!heap_empty(&rw->read_waiters))
+	{
+		struct thread *t = heap_entry(heap_pop(&rw->read_waiters), struct thread, wait_elem);
+
+		t->wait_heap = NULL;
+		t->waiting_rw = NULL;
+		rwlock_grant(rw, t, false);
+		thread_unblock(t);
+	}
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or is
+   waiting for it.  The current thread must not already hold RW,
+   and may hold at most RWLOCK_HOLD_MAX - 1 other rwlocks.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_read (struct rwlock *rw) {
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+	bool profiled = rw->stat != NULL && lock_profile;
+	bool contended = false;
+	uint64_t wait_start;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (rwlock_hold_find (cur, rw) == NULL);
+	ASSERT (rwlock_hold_find (cur, NULL) != NULL);
+
+	old_level = intr_disable ();
+	wait_start = profiled ? timer_now_ns () : 0;
+	if (rw->writer == NULL && heap_empty (&rw->write_waiters))
+		rwlock_grant (rw, cur, false);
+	else {
+		contended = true;
+		rwlock_wait (rw, &rw->read_waiters);
+	}
+	if (profiled)
+		lock_stat_acquired (rw->stat, wait_start, contended,
+				&rwlock_hold_find (cur, rw)->since);
+	intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread holds for reading. */
+void
+rwlock_release_read (struct rwlock *rw) {
+	struct thread *cur = thread_current ();
+	struct rwlock_hold *hold;
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	hold = rwlock_hold_find (cur, rw);
+	ASSERT (hold != NULL && rw->writer == NULL);
+
+	old_level = intr_disable ();
+	if (rw->stat != NULL && lock_profile)
+		lock_stat_released (rw->stat, hold->since);
+	rw->readers--;
+	list_remove (&hold->elem);
+	hold->rw = NULL;
+	if (!thread_mlfqs)
+		multiple_donation ();
+
+	rwlock_wake (rw);
+	thread_maybe_yield ();
+	intr_set_level (old_level);
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it.  The current thread must not already hold RW, and may hold
+   at most RWLOCK_HOLD_MAX - 1 other rwlocks.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_write (struct rwlock *rw) {
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+	bool profiled = rw->stat != NULL && lock_profile;
+	bool contended = false;
+	uint64_t wait_start;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (rwlock_hold_find (cur, rw) == NULL);
+	ASSERT (rwlock_hold_find (cur, NULL) != NULL);
+
+	old_level = intr_disable ();
+	wait_start = profiled ? timer_now_ns () : 0;
+	if (rw->writer == NULL && rw->readers == 0)
+		rwlock_grant (rw, cur, true);
+	else {
+		contended = true;
+		rwlock_wait (rw, &rw->write_waiters);
+	}
+	if (profiled)
+		lock_stat_acquired (rw->stat, wait_start, contended,
+				&rwlock_hold_find (cur, rw)->since);
+	intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread holds for writing. */
+void
+rwlock_release_write (struct rwlock *rw) {
+	struct thread *cur = thread_current ();
+	struct rwlock_hold *hold;
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (rw->writer == cur);
+	hold = rwlock_hold_find (cur, rw);
+
+	old_level = intr_disable ();
+	if (rw->stat != NULL && lock_profile)
+		lock_stat_released (rw->stat, hold->since);
+	rw->writer = NULL;
+	hold->rw = NULL;
+	if (!thread_mlfqs)
+		multiple_donation ();
+
+	rwlock_wake (rw);
+	thread_maybe_yield ();
+	intr_set_level (old_level);
+}
+
+/* One semaphore in a condition variable's waiters. */
 struct semaphore_elem {
-	struct list_elem elem;              /* List element. */
+	struct heap_elem elem;              /* Heap element. */
 	struct semaphore semaphore;         /* This semaphore. */
 	int priority; // semaphore에는 우선순위 정보가 없어 비교군이 없음
+	uint64_t seq; // 같은 우선순위끼리 FIFO를 지키기 위한 대기 순번
 };
 
 /* Initializes condition variable COND.  A condition variable
@@ -361,7 +888,7 @@ void
 cond_init (struct condition *cond) {
 	ASSERT (cond != NULL);
 
-	list_init (&cond->waiters);
+	heap_init (&cond->waiters, cond_sema_priority, NULL);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -398,18 +925,26 @@ void cond_wait (struct condition *cond, struct lock *lock)
 	ASSERT (lock_held_by_current_thread (lock));
 
 	sema_init (&waiter.semaphore, 0);	// 조건 변수에서 대기할 개별 세마포어 초기화
-	// list_push_back (&cond->waiters, &waiter.elem); // cond->waiters 리스트 뒤로 삽입 (FIFO)
 	waiter.priority = thread_current()->priority;
-	list_insert_ordered (&cond->waiters, &waiter.elem, cond_sema_priority, NULL); // +
+	enum intr_level old_level = intr_disable();
+	waiter.seq = next_wait_seq++;
+	heap_push (&cond->waiters, &waiter.elem); // 우선순위 힙에 삽입 (O(1))
+	intr_set_level(old_level);
 
 	lock_release (lock); // 현재 보유중인 lock 해제
 	sema_down (&waiter.semaphore); // 세마포어를 통해 block 상태로 진입
 	lock_acquire (lock); // 깨어난 이후 다시 lock 획득
 }
 
-bool cond_sema_priority(const struct list_elem *a, const struct list_elem *b, void *aux)
+/// @brief 조건 변수 waiters 힙의 비교 함수: 우선순위가 낮거나, 같으면 나중에 온 대기자가 작음
+bool cond_sema_priority(const struct heap_elem *a_, const struct heap_elem *b_, void *aux UNUSED)
 {
-	return list_entry (a, struct semaphore_elem, elem)->priority > list_entry (b, struct semaphore_elem, elem)->priority;
+	const struct semaphore_elem *a = heap_entry (a_, struct semaphore_elem, elem);
+	const struct semaphore_elem *b = heap_entry (b_, struct semaphore_elem, elem);
+
+	if (a->priority != b->priority)
+		return a->priority < b->priority;
+	return a->seq > b->seq;
 }
 /* If any threads are waiting on COND (protected by LOCK), then
    this function signals one of them to wake up from its wait.
@@ -429,12 +964,10 @@ void cond_signal (struct condition *cond, struct lock *lock UNUSED)
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	if (!list_empty (&cond->waiters)) // 조건 변수에 대기 중인 스레드가 있다면
+	if (!heap_empty (&cond->waiters)) // 조건 변수에 대기 중인 스레드가 있다면
 	{
-		// cond->waiters의 리스트를 우선순위 순으로 정렬
-		list_sort(&cond->waiters, cond_sema_priority, NULL); // ++
-		// 우선순위가 높은 대기자를 pop하고 해당 스레드 꺠움
-		sema_up (&list_entry (list_pop_front (&cond->waiters), struct semaphore_elem, elem)->semaphore);
+		// 우선순위가 높은 대기자를 pop하고 해당 스레드 꺠움 (O(log n))
+		sema_up (&heap_entry (heap_pop (&cond->waiters), struct semaphore_elem, elem)->semaphore);
 	}
 }
 
@@ -449,6 +982,6 @@ cond_broadcast (struct condition *cond, struct lock *lock) {
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 
-	while (!list_empty (&cond->waiters))
+	while (!heap_empty (&cond->waiters))
 		cond_signal (cond, lock);
 }
@@ -4,12 +4,17 @@
 #include <random.h>
 #include <stdio.h>
 #include <string.h>
+#include "devices/timer.h"
+#include "threads/fixed_point.h"
 #include "threads/flags.h"
+#include "threads/fpu.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
+#include "threads/switch.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "atomic.h"
 #include "intrinsic.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -24,9 +29,17 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Lists of processes in THREAD_READY state, that is, processes
+   that are ready to run but not actually running.  There is one
+   FIFO queue per priority level, and bit N of ready_mask is set
+   iff ready_queues[N] is nonempty, so the highest runnable
+   priority is a single find-first-set away. */
+#if PRI_MAX - PRI_MIN + 1 > 64
+#error ready_mask can only track 64 priority levels
+#endif
+static struct list ready_queues[PRI_MAX + 1];
+static uint64_t ready_mask;
+static int ready_cnt;           /* # of threads in ready_queues. */
 
 /* Idle thread. */
 static struct thread *idle_thread;
@@ -34,21 +47,23 @@ static struct thread *idle_thread;
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
 
-/* Lock used by allocate_tid(). */
-static struct lock tid_lock;
-
 /* Thread destruction requests */
 static struct list destruction_req;
 
-// 잠든 스레드 관리 리스트
-static struct list sleep_list;
-// 슬립 리스트에 다음에 검사해야 할 최소 틱 시간 저장 변수
-static int64_t next_tick_to_awake;
+/* Recycling cache.  Pages of dead threads are kept here up to a
+   bound instead of going back to palloc.  A recycled thread page
+   needs only its struct thread reset by init_thread(), so reuse
+   skips zeroing a whole page as well as the pool bitmap scan.
+   Accessed with interrupts off. */
+#define THREAD_CACHE_MAX 16
+static struct thread *thread_cache[THREAD_CACHE_MAX];
+static size_t thread_cache_cnt;
+static long long thread_cache_hits, thread_cache_misses;
 
 /* Statistics. */
-static long long idle_ticks;    /* # of timer ticks spent idle. */
-static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
-static long long user_ticks;    /* # of timer ticks in user programs. */
+static int64_t idle_ticks;      /* # of timer ticks spent idle. */
+static int64_t kernel_ticks;    /* # of timer ticks in kernel threads. */
+static int64_t user_ticks;      /* # of timer ticks in user programs. */
 
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
@@ -59,6 +74,51 @@ static unsigned thread_ticks;   /* # of timer ticks since last yield. */
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* 4.4BSD scheduler state.  load_avg and the recent_cpu decay run
+   once per second; each run is one "epoch".  Only the running
+   and ready threads are decayed eagerly.  A blocked thread
+   remembers the epoch it was last brought up to date in and
+   replays the missed decays from decay_coef[] when it wakes up,
+   so the per-second work does not depend on how many threads are
+   sleeping. */
+#define DECAY_HISTORY 128       /* Epochs of decay_coef[] kept. */
+static fixed_t load_avg;        /* System load average. */
+static int64_t mlfqs_epoch;     /* # of once-per-second updates so far. */
+static fixed_t decay_coef[DECAY_HISTORY]; /* Decay used to enter epoch E. */
+
+/* CFS scheduler state.  Ready threads sit in a red-black tree
+   ordered by vruntime, and the leftmost one runs next.  Each tick
+   adds CFS_TICK_VRUNTIME * CFS_WEIGHT_DEFAULT / weight to the
+   running thread's vruntime, where weight grows by 10% per
+   priority level, so a thread's CPU share is proportional to its
+   weight.  A donated priority raises the weight of the lock
+   holder in the same way.  cfs_min_vruntime only moves forward
+   and is where new and woken threads are placed, so a thread
+   that slept cannot come back owed more than CFS_GRANULARITY. */
+#define CFS_WEIGHT_DEFAULT 1024         /* Weight of PRI_DEFAULT. */
+#define CFS_TICK_VRUNTIME (1 << 16)     /* vruntime of one tick at PRI_DEFAULT. */
+#define CFS_GRANULARITY (TIME_SLICE * CFS_TICK_VRUNTIME) /* Lead before preempting. */
+#define CFS_WAKEUP_GRANULARITY CFS_TICK_VRUNTIME /* Same, for a woken thread. */
+bool thread_cfs;
+static struct rbtree cfs_timeline;
+static uint64_t cfs_min_vruntime;
+static unsigned cfs_weights[PRI_MAX + 1];
+
+/* EDF real-time class.  A thread that reserved (runtime, period,
+   deadline) with thread_set_edf() runs ahead of every normal
+   thread while it has budget left, and among such threads the
+   earliest absolute deadline runs first.  thread_tick() charges
+   the budget; a thread that uses it up drops back to the normal
+   scheduler until its edf_timer starts the next period, which
+   restores the budget and moves the deadline on.  Admission keeps
+   the sum of runtime/deadline over all reservations at or below
+   EDF_BW_MAX, which is enough for EDF to meet every deadline. */
+#define EDF_BW_ONE (1 << 20)            /* Bandwidth of a whole CPU. */
+#define EDF_BW_MAX (EDF_BW_ONE / 100 * 95) /* Leave 5% to normal threads. */
+static struct heap edf_ready;   /* Ready EDF threads with budget, by deadline. */
+static int64_t edf_bw_total;    /* Sum of admitted bandwidth. */
+static long long edf_throttles; /* # of times a budget ran out. */
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
@@ -67,6 +127,31 @@ static void init_thread (struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule (void);
 static tid_t allocate_tid (void);
+static tid_t thread_spawn (const char *name, int priority, thread_func *, void *aux, bool waitable);
+static void ready_queue_push (struct thread *);
+static void ready_queue_remove (struct thread *);
+static int ready_max_priority (void);
+static void thread_wakeup (void *t_);
+static struct thread *thread_page_get (void);
+static void thread_page_put (struct thread *);
+static void mlfqs_tick (struct thread *);
+static void mlfqs_catch_up (struct thread *);
+static int mlfqs_priority (const struct thread *);
+static bool ready_should_preempt (const struct thread *);
+static bool cfs_less (const struct rb_node *, const struct rb_node *, void *aux);
+static void cfs_tick (struct thread *);
+static void cfs_update_min_vruntime (void);
+static bool edf_less (const struct heap_elem *, const struct heap_elem *, void *aux);
+static void edf_replenish (void *t_);
+static void edf_release (struct thread *);
+static bool ready_empty (void);
+
+/* Returns true if T is an EDF thread with budget left, which is
+   scheduled ahead of all normal threads. */
+static inline bool
+edf_active (const struct thread *t) {
+	return t->edf_runtime > 0 && t->edf_budget > 0;
+}
 
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
@@ -102,7 +187,7 @@ void thread_maybe_yield (void)
 {
 	enum intr_level old_level = intr_disable ();
 
-	if (!list_empty (&ready_list) && thread_current ()->priority < list_entry (list_front (&ready_list), struct thread, elem)->priority) {
+	if (ready_should_preempt (thread_current ())) {
 		if (intr_context())
 			intr_yield_on_return();
         else
@@ -126,11 +211,17 @@ void thread_init(void)
 	lgdt (&gdt_ds);
 
 	/* Init the globla thread context */
-	lock_init (&tid_lock);
-	list_init (&ready_list);
+	for (int pri = PRI_MIN; pri <= PRI_MAX; pri++)
+		list_init (&ready_queues[pri]);
+	ready_mask = 0;
+	rb_init (&cfs_timeline, cfs_less, NULL);
+	heap_init (&edf_ready, edf_less, NULL);
+	cfs_weights[PRI_DEFAULT] = CFS_WEIGHT_DEFAULT;
+	for (int pri = PRI_DEFAULT + 1; pri <= PRI_MAX; pri++)
+		cfs_weights[pri] = cfs_weights[pri - 1] * 11 / 10;
+	for (int pri = PRI_DEFAULT - 1; pri >= PRI_MIN; pri--)
+		cfs_weights[pri] = cfs_weights[pri + 1] * 10 / 11;
 	list_init (&destruction_req);
-	list_init (&sleep_list);
-	next_tick_to_awake = INT64_MAX;
 
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread ();
@@ -163,13 +254,28 @@ thread_tick (void) {
 
 	/* Update statistics. */
 	if (t == idle_thread)
-		idle_ticks++;
+		atomic_inc (&idle_ticks);
 #ifdef USERPROG
 	else if (t->pml4 != NULL)
-		user_ticks++;
+		atomic_inc (&user_ticks);
 #endif
 	else
-		kernel_ticks++;
+		atomic_inc (&kernel_ticks);
+
+	if (thread_mlfqs)
+		mlfqs_tick (t);
+	else if (thread_cfs)
+		cfs_tick (t);
+
+	/* EDF threads are not time-sliced; they run until they block,
+	   an earlier deadline arrives, or their budget runs out. */
+	if (edf_active (t)) {
+		if (--t->edf_budget == 0) {
+			edf_throttles++;
+			intr_yield_on_return ();
+		}
+		return;
+	}
 
 	/* Enforce preemption. */
 	if (++thread_ticks >= TIME_SLICE)
@@ -180,7 +286,11 @@ thread_tick (void) {
 void
 thread_print_stats (void) {
 	printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
-			idle_ticks, kernel_ticks, user_ticks);
+			atomic_load (&idle_ticks), atomic_load (&kernel_ticks),
+			atomic_load (&user_ticks));
+	printf ("Thread: page cache %lld hits, %lld misses\n",
+			thread_cache_hits, thread_cache_misses);
+	printf ("Thread: %lld EDF budget overruns\n", edf_throttles);
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -199,15 +309,32 @@ thread_print_stats (void) {
    PRIORITY, but no actual priority scheduling is implemented.
    Priority scheduling is the goal of Problem 1-3. */
 tid_t thread_create (const char *name, int priority, thread_func *function, void *aux) 
+{
+	return thread_spawn (name, priority, function, aux, false);
+}
+
+#ifdef USERPROG
+/// @brief thread_create와 같지만, 부모가 wait할 수 있도록 자식이 실행되기 전에 종료 기록을 만들어 두는 함수
+/// @return 새 스레드의 tid, 스레드나 종료 기록을 만들 수 없으면 TID_ERROR
+tid_t thread_create_process (const char *name, int priority, thread_func *function, void *aux)
+{
+	return thread_spawn (name, priority, function, aux, true);
+}
+#endif
+
+/// @brief thread_create와 thread_create_process의 공통 구현
+/// @param waitable true면 부모와 공유할 종료 기록을 함께 만듦 (USERPROG 전용)
+static tid_t thread_spawn (const char *name, int priority, thread_func *function, void *aux, bool waitable UNUSED)
 {
 	struct thread *t;
 	tid_t tid;
 	struct kernel_thread_frame *kf;
+	struct switch_frame *sf;
 
 	ASSERT (function != NULL); //function 포인터가 NULL아닌지 확인
 
-	/* 쓰레드 할당 */
-	t = palloc_get_page (PAL_ZERO);
+	/* 쓰레드 할당 (재활용 캐시 우선) */
+	t = thread_page_get ();
 	if (t == NULL)
 		return TID_ERROR;
 
@@ -215,41 +342,46 @@ tid_t thread_create (const char *name, int priority, thread_func *function, void
 	init_thread (t, name, priority);
 	tid = t->tid = allocate_tid ();
 
-#ifdef USERPROG
-	t->fd_table = palloc_get_multiple(PAL_ZERO, FDPAGES);
-
-	if (t->fd_table == NULL)
+	// 4.4BSD 스케줄러에서는 부모의 nice, recent_cpu를 물려받고 우선순위는 식으로 계산
+	if (thread_mlfqs)
 	{
-		palloc_free_page(t);
-		return TID_ERROR;
+		struct thread *parent = thread_current();
+
+		t->nice = parent->nice;
+		t->recent_cpu = parent->recent_cpu;
+		t->priority = t->original_priority = mlfqs_priority(t);
 	}
 
-	if (t->fd_table == NULL)
+	// CFS: 새 스레드는 현재 타임라인의 가장 왼쪽 지점에서 시작
+	if (thread_cfs)
+		t->vruntime = cfs_min_vruntime;
+
+#ifdef USERPROG
+	// 부모와 공유할 종료 기록을 자식이 실행되기 전에 만들어 둠 (커널 스레드는 기록 없음)
+	if (waitable && !process_attach_child (t))
+	{
+		thread_page_put (t);
 		return TID_ERROR;
-		
-	t->fd_index = 3; 
-	t->exit_status = 0;
-	list_push_back(&thread_current()->child_list, &t->child_elem);
+	}
 #endif
 
-	/* 스레드가 스케줄되면 kernel_thread를 호출한다. 
-	 	rdi는 첫 번째 인자이고, rsi는 두 번째 인자이다. */
-	t->tf.rip = (uintptr_t) kernel_thread;
-	t->tf.R.rdi = (uint64_t) function;
-	t->tf.R.rsi = (uint64_t) aux;
-	t->tf.ds = SEL_KDSEG;
-	t->tf.es = SEL_KDSEG;
-	t->tf.ss = SEL_KDSEG;
-	t->tf.cs = SEL_KCSEG;
-	t->tf.eflags = FLAG_IF;
+	/* 스레드가 처음 스케줄되면 switch_to()가 switch_entry로 복귀하고,
+	   switch_entry가 kernel_thread(function, aux)를 호출한다.
+	   스택 꼭대기 16바이트는 kernel_thread 진입 시 ABI 정렬을 맞추기 위한 여백. */
+	sf = (struct switch_frame *) ((uint8_t *) t + PGSIZE - 16) - 1;
+	sf->r12 = (uint64_t) kernel_thread;
+	sf->r13 = (uint64_t) function;
+	sf->r14 = (uint64_t) aux;
+	sf->rip = switch_entry;
+	t->ksp = (uint64_t) sf;
 	
 	thread_unblock (t);
 
 	enum intr_level old_level;
 	old_level = intr_disable();
 
-	if (t->priority > thread_current()->priority)
-		thread_maybe_yield();
+	// 새 스레드가 지금 스레드보다 먼저 돌아야 한다면 양보
+	thread_maybe_yield();
 
 	intr_set_level(old_level);
 
@@ -279,7 +411,7 @@ thread_block (void) {
    it may expect that it can atomically unblock a thread and
    update other data. */
 
-/// @brief 블록 상태인 스레드 t를 준비 상태로 전환하고 ready_list에 우선순위에 맞게 삽입
+/// @brief 블록 상태인 스레드 t를 준비 상태로 전환하고 우선순위에 해당하는 준비 큐에 삽입
 /// @param t 준비 상태로 만들 스레드 포인터
 void thread_unblock (struct thread *t) 
 {
@@ -289,8 +421,25 @@ void thread_unblock (struct thread *t)
 
 	old_level = intr_disable (); // 인터럽트 비활성화
 	ASSERT (t->status == THREAD_BLOCKED); 
-	// list_push_back (&ready_list, &t->elem);
-	list_insert_ordered(&ready_list, &t->elem, cmp_priority, NULL); // 우선순위에 따라 리스트에 삽입
+
+	// 4.4BSD 스케줄러: 잠든 동안 밀린 recent_cpu 감쇠를 여기서 한 번에 반영
+	if (thread_mlfqs)
+	{
+		mlfqs_catch_up(t);
+		t->priority = mlfqs_priority(t);
+	}
+
+	// CFS: 오래 잠들었던 스레드가 밀린 몫을 한꺼번에 받아가지 않도록 min_vruntime 근처로 당김
+	if (thread_cfs)
+	{
+		uint64_t floor = cfs_min_vruntime > CFS_GRANULARITY
+			? cfs_min_vruntime - CFS_GRANULARITY : 0;
+
+		if (t->vruntime < floor)
+			t->vruntime = floor;
+	}
+
+	ready_queue_push(t); // 준비 큐에 삽입 (우선순위 큐는 O(1), CFS 타임라인은 O(log n))
 
 	t->status = THREAD_READY; // 상태를 준비 상태로 변경
 	intr_set_level (old_level); // 인터럽트 활성화
@@ -346,10 +495,12 @@ thread_exit (void) {
 #ifdef USERPROG
 	process_exit ();
 #endif
+	fpu_release (thread_current ());
 
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable ();
+	edf_release (thread_current ());
 	do_schedule (THREAD_DYING);
 	NOT_REACHED ();
 }
@@ -357,7 +508,7 @@ thread_exit (void) {
 /* Yields the CPU.  The current thread is not put to sleep and
    may be scheduled again immediately at the scheduler's whim. */
 
-/// @brief 현재 스레드가 CPU 양보(yield)하여 ready_list에 다시 넣고 스케줄링을 유도
+/// @brief 현재 스레드가 CPU 양보(yield)하여 준비 큐에 다시 넣고 스케줄링을 유도
 void thread_yield(void) 
 {
 	//thread_current(): 현재 스레드를 반환
@@ -369,10 +520,9 @@ void thread_yield(void)
 	// intr_disable(): 인터텁트를 비활성화하고 이전 인터럽트 상태를 반환
 	old_level = intr_disable();
 
-	// list_push_back(): 매개변수로 전달된 상태로 인터럽트 상태를 설정하고 이전 인터럽트 상태를 반환
+	// 같은 우선순위 큐의 맨 뒤로 들어가므로 동일 우선순위끼리는 라운드 로빈
 	if (curr != idle_thread)
-		list_insert_ordered(&ready_list, &curr->elem, cmp_priority, NULL);
-		// list_push_back (&ready_list, &curr->elem); // 주어진 항목을 리스트의 마지막에 삽입
+		ready_queue_push(curr);
 	
 	do_schedule(THREAD_READY);
 	intr_set_level(old_level);
@@ -382,25 +532,22 @@ void thread_yield(void)
 // 현재 설정 중인 스레드의 우선순위를 새로운 우선순위로 설정
 
 /// @brief 현재 설정 중인 스레드의 우선순위를 새로운 우선순위로 설정
-///        만약 ready_list 에 높은 우선순위의 스레드가 있다면 CPU를 양보
+///        만약 준비 큐에 높은 우선순위의 스레드가 있다면 CPU를 양보
 /// @param new_priority 변경 할 우선순위 값
 void thread_set_priority (int new_priority) 
 {
-	thread_current()->original_priority = new_priority;
-	multiple_donation();
+	// 4.4BSD 스케줄러에서는 우선순위를 직접 정할 수 없음
+	if (thread_mlfqs)
+		return;
 
 	enum intr_level old_level;
 	old_level = intr_disable();
-	
-	if (!list_empty(&ready_list)) // 리스트가 안비었다면
-	{
-		// ready_list의 맨 앞을 가져옴
-		struct thread *front_thread = list_entry (list_front (&ready_list), struct thread, elem);
 
-		// 맨 앞의 리스트의 우선순위가 높다면 cpu 양보
-		if (front_thread->priority > thread_current()->priority)
-			thread_maybe_yield();
-	}
+	thread_current()->original_priority = new_priority;
+	multiple_donation();
+	
+	// 준비 큐에 먼저 돌아야 할 스레드가 있다면 cpu 양보
+	thread_maybe_yield();
 
 	intr_set_level(old_level);
 }
@@ -412,30 +559,156 @@ thread_get_priority (void) {
 }
 
 /* Sets the current thread's nice value to NICE. */
-void
-thread_set_nice (int nice UNUSED) {
-	/* TODO: Your implementation goes here */
+
+/// @brief 현재 스레드의 nice 값을 바꾸고 우선순위를 다시 계산, 더 이상 최고 우선순위가 아니면 양보
+/// @param nice 새 nice 값 (NICE_MIN ~ NICE_MAX)
+void thread_set_nice (int nice) 
+{
+	struct thread *cur = thread_current();
+	enum intr_level old_level;
+
+	ASSERT (NICE_MIN <= nice && nice <= NICE_MAX);
+
+	old_level = intr_disable();
+	cur->nice = nice;
+	if (thread_mlfqs)
+	{
+		cur->priority = mlfqs_priority(cur);
+		thread_maybe_yield();
+	}
+	intr_set_level(old_level);
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	return thread_current ()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old_level = intr_disable ();
+	int load_avg_100 = fp_to_int_round (mult_mixed (load_avg, 100));
+	intr_set_level (old_level);
+
+	return load_avg_100;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old_level = intr_disable ();
+	int recent_cpu_100 = fp_to_int_round (mult_mixed (thread_current ()->recent_cpu, 100));
+	intr_set_level (old_level);
+
+	return recent_cpu_100;
+}
+
+/// @brief 4.4BSD 스케줄러의 우선순위 식: PRI_MAX - (recent_cpu / 4) - (nice * 2)
+/// @param t 우선순위를 계산할 스레드
+/// @return PRI_MIN ~ PRI_MAX 범위로 자른 우선순위
+static int mlfqs_priority (const struct thread *t)
+{
+	int priority = PRI_MAX - fp_to_int (div_mixed (t->recent_cpu, 4)) - t->nice * 2;
+
+	if (priority < PRI_MIN)
+		priority = PRI_MIN;
+	if (priority > PRI_MAX)
+		priority = PRI_MAX;
+	return priority;
+}
+
+/// @brief 스레드 t가 놓친 초당 recent_cpu 감쇠를 현재 epoch까지 한 번에 적용
+/// @param t 갱신할 스레드 (잠들어 있던 스레드면 깨어날 때 호출됨)
+static void mlfqs_catch_up (struct thread *t)
+{
+	int64_t epoch = t->recent_cpu_epoch;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (epoch == mlfqs_epoch)
+		return;
+
+	// 기록이 남아있지 않을 만큼 오래 잠들었다면 남은 것 중 가장 오래된 계수로 근사
+	if (mlfqs_epoch - epoch > DECAY_HISTORY)
+	{
+		int64_t oldest = mlfqs_epoch - DECAY_HISTORY + 1;
+		int64_t missing = oldest - 1 - epoch;
+
+		if (missing > DECAY_HISTORY)
+			missing = DECAY_HISTORY;
+		for (; missing > 0; missing--)
+			t->recent_cpu = add_mixed (mult_fp (decay_coef[oldest % DECAY_HISTORY],
+						t->recent_cpu), t->nice);
+		epoch = oldest - 1;
+	}
+
+	for (epoch++; epoch <= mlfqs_epoch; epoch++)
+		t->recent_cpu = add_mixed (mult_fp (decay_coef[epoch % DECAY_HISTORY],
+					t->recent_cpu), t->nice);
+	t->recent_cpu_epoch = mlfqs_epoch;
+}
+
+/// @brief 1초마다 load_avg를 갱신하고, 실행 중이거나 준비 상태인 스레드만 감쇠 및 우선순위 재계산
+static void mlfqs_second (void)
+{
+	struct thread *cur = thread_current();
+	int ready_threads = ready_cnt + (cur != idle_thread ? 1 : 0);
+
+	// load_avg = (59/60) * load_avg + (1/60) * ready_threads
+	load_avg = add_fp (div_mixed (mult_mixed (load_avg, 59), 60),
+			div_mixed (int_to_fp (ready_threads), 60));
+
+	// 이번 epoch의 감쇠 계수 (2 * load_avg) / (2 * load_avg + 1) 기록
+	mlfqs_epoch++;
+	decay_coef[mlfqs_epoch % DECAY_HISTORY] = div_fp (mult_mixed (load_avg, 2),
+			add_mixed (mult_mixed (load_avg, 2), 1));
+
+	if (cur != idle_thread)
+	{
+		mlfqs_catch_up(cur);
+		cur->priority = mlfqs_priority(cur);
+	}
+
+	// 준비 큐를 높은 우선순위부터 순회. 낮은 큐로 옮겨진 스레드는 다시 방문되지만
+	// 이미 이번 epoch까지 갱신되었으므로 아무 일도 하지 않음
+	for (int pri = PRI_MAX; pri >= PRI_MIN; pri--)
+	{
+		struct list_elem *e;
+
+		if (!(ready_mask & (1ULL << pri)))
+			continue;
+
+		for (e = list_begin(&ready_queues[pri]); e != list_end(&ready_queues[pri]); )
+		{
+			struct thread *t = list_entry(e, struct thread, elem);
+
+			e = list_next(e);
+			mlfqs_catch_up(t);
+			thread_update_priority(t, mlfqs_priority(t));
+		}
+	}
+}
+
+/// @brief 4.4BSD 스케줄러의 틱 처리: recent_cpu 증가, 1초마다 전체 갱신, 4틱마다 현재 스레드 우선순위 재계산
+/// @param t 현재 실행 중인 스레드
+static void mlfqs_tick (struct thread *t)
+{
+	int64_t now = timer_ticks();
+
+	if (t != idle_thread)
+		t->recent_cpu = add_mixed(t->recent_cpu, 1);
+
+	// 실행 중이 아닌 스레드의 recent_cpu는 1초마다만 바뀌므로
+	// 4틱마다 다시 계산할 대상은 현재 스레드 하나뿐
+	if (now % TIMER_FREQ == 0)
+		mlfqs_second();
+	else if (now % 4 == 0 && t != idle_thread)
+		t->priority = mlfqs_priority(t);
+
+	if (ready_max_priority() > t->priority)
+		intr_yield_on_return();
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -459,6 +732,20 @@ idle (void *idle_started_ UNUSED) {
 		intr_disable ();
 		thread_block ();
 
+		/* Spend the idle time filling the pre-zeroed page pools,
+		   a chunk at a time so that a thread that becomes ready is
+		   not kept waiting. */
+		intr_enable ();
+		while (ready_empty () && palloc_zero_step ())
+			continue;
+		intr_disable ();
+		if (!ready_empty ())
+			continue;
+
+		/* With -tickless, stop the periodic timer interrupt until
+		   the next timer deadline. */
+		timer_idle_stop_tick ();
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -501,12 +788,22 @@ static void init_thread (struct thread *t, const char *name, int priority)
 	memset (t, 0, sizeof *t); // t가 가리키는 메모리 블록 모두 0으로 초기화
 	t->status = THREAD_BLOCKED; // 스레드 상태를 blocked으로 설정
 	strlcpy (t->name, name, sizeof t->name); // 주어진 namae 문자열을 스레드 구조체의 name 필드에 복사
-	t->tf.rsp = (uint64_t) t + PGSIZE - sizeof (void *); // 이 스레드가 사용할 스택 포인터 초기화
 	
 	t->priority = priority; // 스레드 우선순위 설정
 	t->original_priority = priority; // 기존 우선순위 주입
 	t->waiting_lock = NULL;   		 // 대기중인 락 초기화
-	list_init(&t->donations); 		 // 리스트 초기화
+	t->waiting_rw = NULL;
+	t->wait_heap = NULL;     		 // 대기자 힙 초기화
+	for (int i = 0; i < RWLOCK_HOLD_MAX; i++) // 보유 중인 rwlock 초기화
+	{
+		t->rw_holds[i].rw = NULL;
+		t->rw_holds[i].thread = t;
+	}
+	heap_init(&t->held_locks, lock_cmp_priority, NULL); // 보유 락 힙 초기화
+
+	t->nice = NICE_DEFAULT;
+	t->recent_cpu = 0;
+	t->recent_cpu_epoch = mlfqs_epoch;
 
 	t->magic = THREAD_MAGIC; // 스레드가 올바르게 초기화 되었는지 검증하기 위한 값 (스택 오버플로우 탐지용)
 #ifdef USERPROG
@@ -514,13 +811,12 @@ static void init_thread (struct thread *t, const char *name, int priority)
 	t->exit_status = 0; // 초기화 기본 종료 상태 0
 
 	t->runn_file = NULL; 
-	t->fd_index = 3;
-	t->fd_table = NULL;
 
-	list_init(&t->child_list);
-	sema_init(&t->fork_sema, 0);
-	sema_init(&t->exit_sema, 0);
-	sema_init(&t->wait_sema, 0); 
+	// 처음에는 스레드 안의 작은 인라인 테이블을 사용, 0~2번은 표준 입출력용으로 예약
+	t->fd_table = t->fd_inline;
+	t->fd_map = &t->fd_inline_map;
+	t->fd_cap = FD_INLINE;
+	t->fd_inline_map = 0x7;
 #endif
 }
 
@@ -531,10 +827,296 @@ static void init_thread (struct thread *t, const char *name, int priority)
    idle_thread. */
 static struct thread *
 next_thread_to_run (void) {
-	if (list_empty (&ready_list))
+	if (!heap_empty (&edf_ready)) {
+		struct thread *t = heap_entry (heap_top (&edf_ready), struct thread, edf_elem);
+		ready_queue_remove (t);
+		return t;
+	}
+	if (thread_cfs) {
+		struct rb_node *first = rb_first (&cfs_timeline);
+
+		if (first == NULL)
+			return idle_thread;
+		struct thread *t = rb_entry (first, struct thread, cfs_elem);
+		ready_queue_remove (t);
+		return t;
+	}
+	if (ready_mask == 0)
 		return idle_thread;
+	else {
+		struct thread *t = list_entry (list_front (&ready_queues[ready_max_priority ()]),
+				struct thread, elem);
+		ready_queue_remove (t);
+		return t;
+	}
+}
+
+/// @brief 스레드 t를 자신의 우선순위에 해당하는 준비 큐 맨 뒤에 넣고 비트맵에 표시
+/// @param t 준비 상태가 될 스레드
+static void ready_queue_push (struct thread *t)
+{
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	// 예산이 남은 EDF 스레드는 마감 시각 순 힙으로
+	if (edf_active (t)) {
+		heap_push (&edf_ready, &t->edf_elem);
+		t->edf_queued = true;
+		ready_cnt++;
+		return;
+	}
+	if (thread_cfs) {
+		rb_insert (&cfs_timeline, &t->cfs_elem);
+		ready_cnt++;
+		return;
+	}
+	list_push_back (&ready_queues[t->priority], &t->elem);
+	ready_mask |= 1ULL << t->priority;
+	ready_cnt++;
+}
+
+/// @brief 준비 큐에서 스레드 t를 빼고, 큐가 비면 비트맵에서 지움
+/// @param t 준비 큐에 들어있는 스레드
+static void ready_queue_remove (struct thread *t)
+{
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (t->edf_queued) {
+		heap_remove (&edf_ready, &t->edf_elem);
+		t->edf_queued = false;
+		ready_cnt--;
+		return;
+	}
+	if (thread_cfs) {
+		rb_remove (&cfs_timeline, &t->cfs_elem);
+		ready_cnt--;
+		return;
+	}
+	list_remove (&t->elem);
+	if (list_empty (&ready_queues[t->priority]))
+		ready_mask &= ~(1ULL << t->priority);
+	ready_cnt--;
+}
+
+/// @brief 준비 큐에 있는 스레드 중 가장 높은 우선순위 (find-first-set 한 번)
+/// @return 최고 우선순위, 준비 큐가 비어있으면 PRI_MIN - 1
+static int ready_max_priority (void)
+{
+	if (ready_mask == 0)
+		return PRI_MIN - 1;
+	return 63 - __builtin_clzll (ready_mask);
+}
+
+/// @brief 준비된 스레드가 하나도 없는지 (EDF 힙, CFS 타임라인, 우선순위 큐 모두)
+static bool ready_empty (void)
+{
+	if (!heap_empty (&edf_ready))
+		return false;
+	return thread_cfs ? rb_empty (&cfs_timeline) : ready_mask == 0;
+}
+
+/// @brief 준비 큐에 CUR보다 먼저 돌아야 할 스레드가 있는지
+///
+/// 우선순위 스케줄러에서는 더 높은 우선순위가 있을 때, CFS에서는 타임라인 맨 왼쪽 스레드의
+/// vruntime이 CUR보다 CFS_WAKEUP_GRANULARITY 넘게 뒤처져 있을 때 true
+static bool ready_should_preempt (const struct thread *cur)
+{
+	struct heap_elem *edf_top = heap_top (&edf_ready);
+
+	// EDF 스레드는 일반 스레드보다 항상 먼저, EDF끼리는 마감 시각이 이른 쪽이 먼저
+	if (edf_top != NULL)
+		return !edf_active (cur) || heap_entry (edf_top, struct thread, edf_elem)->edf_deadline
+			< cur->edf_deadline;
+	if (edf_active (cur))
+		return false;
+
+	if (thread_cfs) {
+		struct rb_node *first = rb_first (&cfs_timeline);
+
+		if (first == NULL)
+			return false;
+		if (cur == idle_thread)
+			return true;
+		return rb_entry (first, struct thread, cfs_elem)->vruntime
+			+ CFS_WAKEUP_GRANULARITY < cur->vruntime;
+	}
+	return cur->priority < ready_max_priority ();
+}
+
+/* Makes the running thread an EDF real-time thread that needs
+   RUNTIME ticks of CPU in every PERIOD ticks, each time within
+   DEADLINE ticks of the period's start.  Replaces any reservation
+   the thread already has.  Returns false, leaving the thread as it
+   was, if the parameters do not satisfy 0 < RUNTIME <= DEADLINE <=
+   PERIOD or if admitting them would overcommit the CPU.
+
+   Priority donation still works through the thread's priority, so
+   give threads that share locks with EDF threads no lower a
+   priority than they need. */
+bool
+thread_set_edf (int64_t runtime, int64_t period, int64_t deadline) {
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+	int64_t bw, now;
+
+	ASSERT (!intr_context ());
+
+	if (runtime <= 0 || runtime > deadline || deadline > period)
+		return false;
+	bw = runtime * EDF_BW_ONE / deadline;
+
+	old_level = intr_disable ();
+	if (edf_bw_total - cur->edf_bw + bw > EDF_BW_MAX) {
+		intr_set_level (old_level);
+		return false;
+	}
+
+	edf_release (cur);
+	edf_bw_total += bw;
+	cur->edf_bw = bw;
+	cur->edf_runtime = runtime;
+	cur->edf_period = period;
+	cur->edf_rel_deadline = deadline;
+
+	now = timer_ticks ();
+	cur->edf_deadline = now + deadline;
+	cur->edf_budget = runtime;
+	timer_add (&cur->edf_timer, now + period, edf_replenish, cur);
+
+	thread_maybe_yield ();
+	intr_set_level (old_level);
+	return true;
+}
+
+/* Returns the running thread to the normal scheduler and gives
+   back its EDF bandwidth. */
+void
+thread_clear_edf (void) {
+	enum intr_level old_level = intr_disable ();
+
+	edf_release (thread_current ());
+	thread_maybe_yield ();
+	intr_set_level (old_level);
+}
+
+/// @brief 스레드 T의 EDF 예약을 해제하고 대역폭을 돌려줌 (T는 실행 중이어야 함, 인터럽트 off 상태에서 호출)
+static void edf_release (struct thread *t)
+{
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (t->edf_runtime == 0)
+		return;
+	timer_cancel (&t->edf_timer);
+	edf_bw_total -= t->edf_bw;
+	t->edf_bw = 0;
+	t->edf_runtime = 0;
+	t->edf_budget = 0;
+}
+
+/// @brief 새 주기 시작: 예산을 채우고 마감 시각을 한 주기 뒤로 옮긴 뒤 다음 주기 타이머를 다시 걺
+/// @param t_ EDF 스레드 (타이머 인터럽트 안에서 호출)
+static void edf_replenish (void *t_)
+{
+	struct thread *t = t_;
+	int64_t start = t->edf_deadline - t->edf_rel_deadline + t->edf_period;
+	bool ready = t->status == THREAD_READY;
+
+	// 준비 상태라면 큐를 옮기거나 힙 키가 바뀌므로 뺐다가 다시 넣음
+	if (ready)
+		ready_queue_remove (t);
+	t->edf_budget = t->edf_runtime;
+	t->edf_deadline = start + t->edf_rel_deadline;
+	if (ready)
+		ready_queue_push (t);
+
+	timer_add (&t->edf_timer, start + t->edf_period, edf_replenish, t);
+	thread_maybe_yield ();
+}
+
+/// @brief EDF 준비 힙의 비교 함수: 마감 시각이 늦은 스레드가 작음 (가장 이른 마감이 루트)
+static bool edf_less (const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED)
+{
+	return heap_entry (a, struct thread, edf_elem)->edf_deadline
+		> heap_entry (b, struct thread, edf_elem)->edf_deadline;
+}
+
+/* Returns the CFS weight of a thread at PRIORITY. */
+unsigned
+thread_cfs_weight (int priority) {
+	ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
+
+	return cfs_weights[priority];
+}
+
+/// @brief CFS 타임라인 비교 함수: vruntime이 작은 스레드가 왼쪽
+static bool cfs_less (const struct rb_node *a, const struct rb_node *b, void *aux UNUSED)
+{
+	return rb_entry (a, struct thread, cfs_elem)->vruntime
+		< rb_entry (b, struct thread, cfs_elem)->vruntime;
+}
+
+/// @brief 실행 중인 스레드 T에 한 틱만큼의 가중 실행 시간을 더하고, 충분히 앞서 나갔으면 양보 요청
+static void cfs_tick (struct thread *t)
+{
+	struct rb_node *first;
+
+	if (t == idle_thread)
+		return;
+
+	t->vruntime += (uint64_t) CFS_TICK_VRUNTIME * CFS_WEIGHT_DEFAULT
+		/ cfs_weights[t->priority];
+	cfs_update_min_vruntime ();
+
+	first = rb_first (&cfs_timeline);
+	if (first != NULL && rb_entry (first, struct thread, cfs_elem)->vruntime
+			+ CFS_GRANULARITY < t->vruntime)
+		intr_yield_on_return ();
+}
+
+/// @brief cfs_min_vruntime을 실행 중인 스레드와 타임라인 맨 왼쪽 중 작은 vruntime까지 끌어올림 (감소하지 않음)
+static void cfs_update_min_vruntime (void)
+{
+	struct thread *cur = running_thread ();
+	struct rb_node *first = rb_first (&cfs_timeline);
+	uint64_t min;
+
+	if (first != NULL)
+		min = rb_entry (first, struct thread, cfs_elem)->vruntime;
+	else if (cur != idle_thread)
+		min = cur->vruntime;
+	else
+		return;
+	if (cur != idle_thread && cur->vruntime < min)
+		min = cur->vruntime;
+
+	if (min > cfs_min_vruntime)
+		cfs_min_vruntime = min;
+}
+
+/// @brief 스레드 t의 (기부 반영) 우선순위를 바꾸고, 준비 상태라면 새 우선순위 큐로 옮김
+/// @param t 우선순위를 바꿀 스레드
+/// @param priority 새 우선순위
+void thread_update_priority (struct thread *t, int priority)
+{
+	enum intr_level old_level = intr_disable ();
+
+	ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
+
+	if (t->status == THREAD_READY && t->priority != priority) {
+		ready_queue_remove (t);
+		t->priority = priority;
+		ready_queue_push (t);
+	}
+	else if (t->status == THREAD_BLOCKED && t->wait_heap != NULL
+			&& t->priority != priority) {
+		int old_priority = t->priority;
+
+		t->priority = priority;
+		waiter_reprioritize (t, old_priority);
+	}
 	else
-		return list_entry (list_pop_front (&ready_list), struct thread, elem);
+		t->priority = priority;
+
+	intr_set_level (old_level);
 }
 
 /* Use iretq to launch the thread */
@@ -565,75 +1147,6 @@ do_iret (struct intr_frame *tf) {
 			: : "g" ((uint64_t) tf) : "memory");
 }
 
-/* Switching the thread by activating the new thread's page
-   tables, and, if the previous thread is dying, destroying it.
-
-   At this function's invocation, we just switched from thread
-   PREV, the new thread is already running, and interrupts are
-   still disabled.
-
-   It's not safe to call printf() until the thread switch is
-   complete.  In practice that means that printf()s should be
-   added at the end of the function. */
-static void
-thread_launch (struct thread *th) {
-	uint64_t tf_cur = (uint64_t) &running_thread ()->tf;
-	uint64_t tf = (uint64_t) &th->tf;
-	ASSERT (intr_get_level () == INTR_OFF);
-
-	/* The main switching logic.
-	 * We first restore the whole execution context into the intr_frame
-	 * and then switching to the next thread by calling do_iret.
-	 * Note that, we SHOULD NOT use any stack from here
-	 * until switching is done. */
-	__asm __volatile (
-			/* Store registers that will be used. */
-			"push %%rax\n"
-			"push %%rbx\n"
-			"push %%rcx\n"
-			/* Fetch input once */
-			"movq %0, %%rax\n"
-			"movq %1, %%rcx\n"
-			"movq %%r15, 0(%%rax)\n"
-			"movq %%r14, 8(%%rax)\n"
-			"movq %%r13, 16(%%rax)\n"
-			"movq %%r12, 24(%%rax)\n"
-			"movq %%r11, 32(%%rax)\n"
-			"movq %%r10, 40(%%rax)\n"
-			"movq %%r9, 48(%%rax)\n"
-			"movq %%r8, 56(%%rax)\n"
-			"movq %%rsi, 64(%%rax)\n"
-			"movq %%rdi, 72(%%rax)\n"
-			"movq %%rbp, 80(%%rax)\n"
-			"movq %%rdx, 88(%%rax)\n"
-			"pop %%rbx\n"              // Saved rcx
-			"movq %%rbx, 96(%%rax)\n"
-			"pop %%rbx\n"              // Saved rbx
-			"movq %%rbx, 104(%%rax)\n"
-			"pop %%rbx\n"              // Saved rax
-			"movq %%rbx, 112(%%rax)\n"
-			"addq $120, %%rax\n"
-			"movw %%es, (%%rax)\n"
-			"movw %%ds, 8(%%rax)\n"
-			"addq $32, %%rax\n"
-			"call __next\n"         // read the current rip.
-			"__next:\n"
-			"pop %%rbx\n"
-			"addq $(out_iret -  __next), %%rbx\n"
-			"movq %%rbx, 0(%%rax)\n" // rip
-			"movw %%cs, 8(%%rax)\n"  // cs
-			"pushfq\n"
-			"popq %%rbx\n"
-			"mov %%rbx, 16(%%rax)\n" // eflags
-			"mov %%rsp, 24(%%rax)\n" // rsp
-			"movw %%ss, 32(%%rax)\n"
-			"mov %%rcx, %%rdi\n"
-			"call do_iret\n"
-			"out_iret:\n"
-			: : "g"(tf_cur), "g" (tf) : "memory"
-			);
-}
-
 /* Schedules a new process. At entry, interrupts must be off.
  * This function modify current thread's status to status and then
  * finds another thread to run and switches to it.
@@ -645,7 +1158,7 @@ do_schedule(int status) {
 	while (!list_empty (&destruction_req)) {
 		struct thread *victim =
 			list_entry (list_pop_front (&destruction_req), struct thread, elem);
-		palloc_free_page(victim);
+		thread_page_put (victim);
 	}
 	thread_current ()->status = status;
 	schedule ();
@@ -669,6 +1182,7 @@ schedule (void) {
 	/* Activate the new address space. */
 	process_activate (next);
 #endif
+	fpu_switch (next);
 
 	if (curr != next) {
 		/* If the thread we switched from is dying, destroy its struct
@@ -683,23 +1197,53 @@ schedule (void) {
 			list_push_back (&destruction_req, &curr->elem);
 		}
 
-		/* Before switching the thread, we first save the information
-		 * of current running. */
-		thread_launch (next);
+		/* Save only the callee-saved registers and stack pointer of
+		 * the current thread and resume NEXT where it left off. */
+		switch_to (&curr->ksp, next->ksp);
+	}
+}
+
+/// @brief 스레드 페이지를 재활용 캐시에서 꺼내고, 비어 있으면 palloc에서 할당
+/// @return 스레드 페이지, 메모리가 없으면 NULL
+/// struct thread는 init_thread()가 초기화하고 나머지는 스택이므로 0으로 채울 필요가 없음
+static struct thread *thread_page_get (void)
+{
+	enum intr_level old_level = intr_disable ();
+	struct thread *t = NULL;
+
+	if (thread_cache_cnt > 0)
+	{
+		t = thread_cache[--thread_cache_cnt];
+		thread_cache_hits++;
 	}
+	else
+		thread_cache_misses++;
+	intr_set_level (old_level);
+
+	if (t == NULL)
+		t = palloc_get_page (0);
+	return t;
+}
+
+/// @brief 다 쓴 스레드 페이지를 캐시에 넣고, 캐시가 가득 찼다면 palloc에 반환
+/// @param t 반환할 스레드 페이지
+static void thread_page_put (struct thread *t)
+{
+	enum intr_level old_level = intr_disable ();
+
+	if (thread_cache_cnt < THREAD_CACHE_MAX)
+		thread_cache[thread_cache_cnt++] = t;
+	else
+		palloc_free_page (t);
+	intr_set_level (old_level);
 }
 
 /* Returns a tid to use for a new thread. */
 static tid_t
 allocate_tid (void) {
-	static tid_t next_tid = 1;
-	tid_t tid;
+	static int64_t next_tid = 1;
 
-	lock_acquire (&tid_lock);
-	tid = next_tid++;
-	lock_release (&tid_lock);
-
-	return tid;
+	return atomic_fetch_add (&next_tid, 1);
 }
 
 /// @brief 현재 스레드를 지정된 틱까지 재우고 CPU에서 제외시킴
@@ -710,43 +1254,46 @@ void thread_sleep(int64_t ticks)
 	struct thread *cur_thread = thread_current(); // 현재 실행 중인 스레드
 
 	if (cur_thread == idle_thread) // 현재 스레드가 idle이면
+	{
+		intr_set_level(old_level);
 		return; // 리턴
+	}
 
-	cur_thread->wakeup_tick = ticks; // 현재 스레드가 깨어나야할 시간 저장
-	list_push_back(&sleep_list, &cur_thread->elem); // 현재 스레드를 슬립 리스트에 추가
+	// 깨어나야 할 시간에 만료되는 타이머를 타이머 휠에 등록 (O(1))
+	timer_add(&cur_thread->sleep_timer, ticks, thread_wakeup, cur_thread);
 
-	if (ticks < next_tick_to_awake) // 가장 빠른 wakeup tick을 나타내는 전역 변수 갱신
-		next_tick_to_awake = ticks;
-	
 	thread_block(); // 현재 스레드를 블락하고 CPU에서 제외
 	intr_set_level(old_level); // 이전 인터럽트 상태로 복원
 }
 
-void thread_awake(int64_t current_ticks)
+/// @brief 현재 스레드를 DEADLINE(ns)까지 잠들게 함. 한 틱보다 짧은 지연에 사용 (hrtimer로 깨움)
+/// @param deadline timer_now_ns() 기준으로 깨어날 시각
+void thread_sleep_ns(uint64_t deadline)
 {
-	struct list_elem *e = list_begin(&sleep_list); // list 순회하기 위한 반복자
-	next_tick_to_awake = INT64_MAX; 
+	struct hrtimer timer;
+	enum intr_level old_level = intr_disable();
+	struct thread *cur_thread = thread_current();
 
-	// sleep_list의 끝까지 반복
-	while (e != list_end(&sleep_list))
+	if (cur_thread == idle_thread) // idle은 블락될 수 없으므로 호출자가 스핀하도록 그냥 리턴
 	{
-		// 리스트 요소를 스레드 구조체로 변환
-		struct thread *t = list_entry(e, struct thread, elem);
-
-		// 깨어나야 할 시간이 현재 시각 이하이면
-		if (t->wakeup_tick <= current_ticks)
-		{
-			e = list_remove(e); // 리스트에서 제거
-			thread_unblock(t); // 해달 스레드 ready 상태로 전환
-		}
-		else
-		{
-			// 아직 꺠어날 시간이 안 됐으면, 최소 wakeup_tick을 갱신
-			if (t->wakeup_tick < next_tick_to_awake)	
-				next_tick_to_awake = t->wakeup_tick;
-			
-			// 다음 리스트로 이동
-			e = list_next(e);
-		}
+		intr_set_level(old_level);
+		return;
 	}
-}
\ No newline at end of file
+
+	// 스레드가 깨어날 때까지 이 함수를 벗어나지 않으므로 타이머는 스택에 둬도 됨
+	timer.pending = false;
+	hrtimer_add(&timer, deadline, thread_wakeup, cur_thread);
+
+	thread_block();
+	intr_set_level(old_level);
+}
+
+/// @brief sleep_timer(또는 hrtimer) 만료 시 인터럽트 안에서 호출되어 잠든 스레드를 깨움
+/// @param t_ 깨울 스레드
+static void thread_wakeup(void *t_)
+{
+	struct thread *t = t_;
+
+	thread_unblock(t); // 해당 스레드 ready 상태로 전환
+	thread_maybe_yield(); // 더 높은 우선순위라면 인터럽트 복귀 시 양보
+}
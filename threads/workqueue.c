@@ -0,0 +1,121 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+/* Shared queues. */
+struct workqueue wq_high;
+struct workqueue wq_default;
+
+static thread_func worker;
+
+/* Starts the shared workqueues.  Must be called after
+   thread_start(), and before any interrupt handler queues work. */
+void
+workqueue_init (void) {
+	workqueue_create (&wq_high, "wq_high", PRI_MAX);
+	workqueue_create (&wq_default, "wq_default", PRI_DEFAULT);
+}
+
+/* Initializes WQ and starts a worker thread named NAME at
+   PRIORITY to serve it. */
+void
+workqueue_create (struct workqueue *wq, const char *name, int priority) {
+	ASSERT (wq != NULL);
+	ASSERT (name != NULL);
+
+	wq->name = name;
+	list_init (&wq->works);
+	sema_init (&wq->wakeup, 0);
+	wq->queued = wq->coalesced = 0;
+	wq->batches = wq->max_batch = 0;
+
+	if (thread_create (name, priority, worker, wq) == TID_ERROR)
+		PANIC ("%s: cannot start worker thread", name);
+}
+
+/* Initializes W to run FUNC with auxiliary data AUX. */
+void
+work_init (struct work *w, work_func *func, void *aux) {
+	ASSERT (w != NULL);
+	ASSERT (func != NULL);
+
+	w->func = func;
+	w->aux = aux;
+	w->pending = false;
+}
+
+/* Queues W on WQ, unless it is already pending.  Returns true if
+   W was queued, false if it was pending.  May be called from an
+   interrupt handler. */
+bool
+work_queue (struct workqueue *wq, struct work *w) {
+	enum intr_level old_level = intr_disable ();
+	bool queued = !w->pending;
+
+	if (queued) {
+		w->pending = true;
+		wq->queued++;
+		if (list_empty (&wq->works))
+			sema_up (&wq->wakeup);
+		list_push_back (&wq->works, &w->elem);
+	} else
+		wq->coalesced++;
+	intr_set_level (old_level);
+	return queued;
+}
+
+/* Worker thread serving workqueue WQ_.  Each time it is woken,
+   runs works one at a time, with interrupts on, until the queue
+   is empty, and counts them as one batch. */
+static void
+worker (void *wq_) {
+	struct workqueue *wq = wq_;
+
+	for (;;) {
+		long long batch_cnt = 0;
+
+		sema_down (&wq->wakeup);
+		for (;;) {
+			enum intr_level old_level = intr_disable ();
+			struct work *w;
+
+			if (list_empty (&wq->works)) {
+				if (batch_cnt > 0) {
+					wq->batches++;
+					if (batch_cnt > wq->max_batch)
+						wq->max_batch = batch_cnt;
+				}
+				intr_set_level (old_level);
+				break;
+			}
+
+			/* Clear PENDING before running W, so that an interrupt
+			   arriving meanwhile can queue it again. */
+			w = list_entry (list_pop_front (&wq->works), struct work, elem);
+			w->pending = false;
+			intr_set_level (old_level);
+
+			w->func (w->aux);
+			batch_cnt++;
+		}
+	}
+}
+
+/* Prints workqueue statistics. */
+void
+workqueue_print_stats (void) {
+	struct workqueue *queues[] = { &wq_high, &wq_default };
+	size_t i;
+
+	for (i = 0; i < sizeof queues / sizeof *queues; i++) {
+		struct workqueue *wq = queues[i];
+
+		if (wq->name == NULL)
+			continue;
+		printf ("Workqueue %s: %lld queued, %lld coalesced, %lld batches"
+				" (largest %lld)\n", wq->name, wq->queued, wq->coalesced,
+				wq->batches, wq->max_batch);
+	}
+}
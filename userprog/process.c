@@ -12,8 +12,10 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "threads/flags.h"
+#include "threads/fpu.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
@@ -29,7 +31,17 @@ static void process_cleanup (void);
 static bool load (const char *file_name, struct intr_frame *if_);
 static void initd (void *f_name);
 static void __do_fork (void *);
-extern struct lock filesys_lock;
+static bool fd_table_grow (struct thread *, int cap);
+static bool fd_table_copy (struct thread *child, struct thread *parent);
+static struct child_status *child_status_find (tid_t);
+static void child_status_release (struct child_status *);
+static hash_hash_func child_status_hash;
+static hash_less_func child_status_less;
+
+#if FD_INLINE > 64
+#error fd_inline_map can only track 64 descriptors
+#endif
+extern struct rwlock filesys_lock;
 
 /* General process initializer for initd and other process. */
 static void
@@ -58,7 +70,7 @@ process_create_initd (const char *file_name) {
 	strtok_r(file_name, " ", &ptr);
 
 	/* Create a new thread to execute FILE_NAME. */
-	tid = thread_create (file_name, PRI_DEFAULT, initd, fn_copy);
+	tid = thread_create_process (file_name, PRI_DEFAULT, initd, fn_copy);
 	if (tid == TID_ERROR)
 		palloc_free_page (fn_copy);
 
@@ -95,25 +107,25 @@ tid_t process_fork (const char *name, struct intr_frame *if_ UNUSED)
 	// 자식 프로세스가 부모의 레지스터 상태를 복제할 수 있도록 parent->parent_if에 저장
 	memcpy(&parent->parent_if, f, sizeof(struct intr_frame));
 	// 자식 스레드 생성
-	tid_t child_tid = thread_create(name, PRI_DEFAULT, __do_fork, parent);
+	tid_t child_tid = thread_create_process(name, PRI_DEFAULT, __do_fork, parent);
 
 	// 자식 생성 실패 시
 	if (child_tid == TID_ERROR)
 		return TID_ERROR;
 
-	// tid로 자식 찾기
-	struct thread *child = get_child_tid(child_tid);
-
-	// 자식을 못찾으면
-	if (child == NULL)
-		return TID_ERROR;
+	// tid로 자식의 종료 기록 찾기 (자식이 이미 끝났어도 기록은 남아 있음)
+	struct child_status *cs = child_status_find(child_tid);
 
 	// 자식이 fork 완료 될때까지 대기
-	sema_down(&child->fork_sema);
+	sema_down(&cs->fork_sema);
 
-	// 자식이 fork중 실패하였다면
-	if (child->exit_status == TID_ERROR)
+	// 자식이 fork중 실패하였다면 기다릴 일이 없으므로 기록을 바로 놓음
+	if (!cs->fork_ok)
+	{
+		hash_delete(&parent->children, &cs->elem);
+		child_status_release(cs);
 		return TID_ERROR;
+	}
 
 	return child_tid;
 }
@@ -219,27 +231,21 @@ static void __do_fork (void *aux)
 	 * TODO:       from the fork() until this function successfully duplicates
 	 * TODO:       the resources of parent.*/
 
-	if (parent->fd_index >= FDCOUNT_LIMIT) // 예외처리
+	if (!fd_table_copy (current, parent)) // 부모의 파일 디스크립터 테이블 복제
 		goto error;
-	
-	current->fd_index = parent->fd_index; // fd_index 복사
 
-	for (int fd = 3; fd < parent->fd_index; fd++) // 부모의 file_index 까지 순회하면서
-	{
-		if (parent->fd_table[fd] == NULL) // NULL인건 건너뛰고
-			continue;
-		
-		current->fd_table[fd] = file_duplicate(parent->fd_table[fd]); // 자식의 파일에 부모의 파일을 복사
-	}
+	if (!fpu_fork (current, parent)) // 부모의 FPU 상태도 복사
+		goto error;
 	
-	sema_up(&current->fork_sema); // fork_sema up
+	current->exit_record->fork_ok = true;
+	sema_up(&current->exit_record->fork_sema); // fork_sema up
 	process_init ();
 	/* Finally, switch to the newly created process. */
 	if (succ)
 		do_iret (&if_);
 error:
 	current->exit_status = -1;
-	sema_up(&current->fork_sema); // 복제 실패 시 현재 fork_sema 블락 해제
+	sema_up(&current->exit_record->fork_sema); // 복제 실패 시 부모의 fork 대기 해제
 	thread_exit ();
 }
 
@@ -265,6 +271,7 @@ int process_exec(void *f_name)
 	/* We first kill the current context */
 	// 현재 사용자 프로세스 정리
 	process_cleanup ();
+	fpu_release (thread_current ()); // 새 프로그램은 깨끗한 FPU 상태에서 시작
 	supplemental_page_table_init (&thread_current()->spt);
 	/* 파싱해서 넘기기 */
 	char *token, *save_ptr; // 토큰 분리에 사용할 포인터
@@ -353,35 +360,92 @@ void argument_stack(char **argv, int argc, struct intr_frame *if_)
 /// @return 종료 상태 반환, 실패 시 -1
 int process_wait (tid_t child_tid UNUSED) 
 {
-	struct thread *child_thread = get_child_tid(child_tid);
+	struct thread *curr = thread_current();
+	struct child_status *cs = child_status_find(child_tid);
 
-	// child_thread가 NULL, 이미 준비중이라면
-	if (child_thread == NULL)
+	// 자식이 아니거나 이미 wait한 자식이라면
+	if (cs == NULL)
 		return -1;
 
-	sema_down(&child_thread->exit_sema); // 자식의 exit_sema 대기 (자식 종료를 대기)
-	int exit_status = child_thread->exit_status; // 자식의 종료 상태 저장
-	list_remove(&child_thread->child_elem); // 자식 리스트에서 제거
-	sema_up(&child_thread->wait_sema); // 자식의 exit() 후 자기 메모리를 해제 할 수 있도록 wait_sema를 올릶
+	sema_down(&cs->exit_sema); // 자식이 종료할 때까지 대기
+	int exit_status = cs->exit_status; // 자식의 종료 상태 저장
+	hash_delete(&curr->children, &cs->elem); // 같은 자식을 두 번 wait할 수 없도록 테이블에서 제거
+	child_status_release(cs);
 	return exit_status;
 }
 
-/// @brief 현재 프로세스의 자식 프로세스를 찾는 함수
+/// @brief 새 스레드의 종료 기록을 만들어 현재 스레드의 자식 테이블에 등록하는 함수 (thread_create_process에서 호출)
+/// @param child 막 만들어져 아직 실행되지 않은 자식 스레드
+/// @return 성공 시 true, 메모리가 부족하면 false
+bool process_attach_child (struct thread *child)
+{
+	struct thread *parent = thread_current();
+	struct child_status *cs;
+
+	// 자식 테이블은 처음 자식을 만들 때 초기화
+	if (parent->children.buckets == NULL
+			&& !hash_init(&parent->children, child_status_hash, child_status_less, NULL))
+		return false;
+
+	cs = malloc(sizeof *cs);
+	if (cs == NULL)
+		return false;
+	cs->tid = child->tid;
+	cs->exit_status = 0;
+	cs->fork_ok = false;
+	cs->ref_cnt = 2; // 부모와 자식이 하나씩
+	sema_init(&cs->fork_sema, 0);
+	sema_init(&cs->exit_sema, 0);
+	hash_insert(&parent->children, &cs->elem);
+	child->exit_record = cs;
+	return true;
+}
+
+/// @brief 현재 프로세스의 자식 중 tid가 CHILD_TID인 자식의 종료 기록을 찾는 함수
 /// @param child_tid 찾고자 하는 자식 프로세스의 TID
-/// @return 성공 시 자식 프로세스 포인터 반환, 실패 시 NULL 
-struct thread *get_child_tid(tid_t child_tid) 
+/// @return 성공 시 종료 기록, 자식이 아니거나 이미 wait했다면 NULL
+static struct child_status *child_status_find (tid_t child_tid)
 {
-    struct thread *parent = thread_current();
-    struct list_elem *e;
+	struct thread *curr = thread_current();
+	struct child_status key;
+	struct hash_elem *e;
+
+	if (curr->children.buckets == NULL)
+		return NULL;
+	key.tid = child_tid;
+	e = hash_find(&curr->children, &key.elem);
+	return e != NULL ? hash_entry(e, struct child_status, elem) : NULL;
+}
 
-    for (e = list_begin(&parent->child_list); e != list_end(&parent->child_list); e = list_next(e)) 
-	  {
-        struct thread *child = list_entry(e, struct thread, child_elem);
+/// @brief 종료 기록에 대한 참조 하나를 놓고, 부모와 자식 모두 놓았다면 해제
+static void child_status_release (struct child_status *cs)
+{
+	enum intr_level old_level = intr_disable();
+	bool last = --cs->ref_cnt == 0;
 
-        if (child->tid == child_tid)
-            return child;
-    }
-    return NULL;  // 못 찾으면 NULL
+	intr_set_level(old_level);
+	if (last)
+		free(cs);
+}
+
+/// @brief 자식 테이블의 해시 함수: tid로 해시
+static uint64_t child_status_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+	const struct child_status *cs = hash_entry(e, struct child_status, elem);
+
+	return hash_int(cs->tid);
+}
+
+/// @brief 자식 테이블의 비교 함수: tid 순
+static bool child_status_less (const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED)
+{
+	return hash_entry(a, struct child_status, elem)->tid < hash_entry(b, struct child_status, elem)->tid;
+}
+
+/// @brief hash_destroy용: 종료하는 부모가 wait하지 않은 자식의 기록을 놓음
+static void child_status_drop (struct hash_elem *e, void *aux UNUSED)
+{
+	child_status_release(hash_entry(e, struct child_status, elem));
 }
 
 /* Exit the process. This function is called by thread_exit (). */
@@ -391,7 +455,7 @@ void process_exit (void)
 {
 	struct thread *curr = thread_current ();
 	// 파일 디스크립터 닫기
-	for (int fd = 0; fd < curr->fd_index; fd++)
+	for (int fd = 3; fd < curr->fd_cap; fd++)
 	{
 		struct file *f = curr->fd_table[fd];
 		
@@ -399,6 +463,7 @@ void process_exit (void)
 		{
 			file_close(f);
 			curr->fd_table[fd] = NULL;
+			curr->fd_map[fd / 64] &= ~(1ULL << (fd % 64));
 		}
 	}
 	
@@ -406,11 +471,29 @@ void process_exit (void)
 	if (curr->runn_file)
 	file_close(curr->runn_file);
 	
-	// 테이블 메모리 해제
-	palloc_free_multiple(curr->fd_table, FDPAGES);
+	// 늘어난 테이블이었다면 해제하고 인라인 테이블로 복귀
+	if (curr->fd_table != curr->fd_inline)
+	{
+		free(curr->fd_table);
+		curr->fd_table = curr->fd_inline;
+		curr->fd_map = &curr->fd_inline_map;
+		curr->fd_cap = FD_INLINE;
+	}
 	process_cleanup ();
-	sema_up(&curr->exit_sema); 	// 부모에게 죽음을 알림
-	sema_down(&curr->wait_sema);// 부모가 wait이 끝날대 까지 대기
+
+	// 종료 상태는 공유 기록에 남기고 부모를 깨움. 부모의 wait을 기다리지 않으므로
+	// 스레드 페이지와 커널 스택은 곧바로 해제됨
+	if (curr->exit_record != NULL)
+	{
+		curr->exit_record->exit_status = curr->exit_status;
+		sema_up(&curr->exit_record->exit_sema);
+		child_status_release(curr->exit_record);
+		curr->exit_record = NULL;
+	}
+
+	// wait하지 않은 자식들의 기록도 놓음
+	if (curr->children.buckets != NULL)
+		hash_destroy(&curr->children, child_status_drop);
 }
 
 /* Free the current process's resources. */
@@ -452,22 +535,89 @@ process_activate (struct thread *next) {
 	tss_update (next);
 }
 
+/// @brief T의 fd 테이블을 CAP칸 이상으로 늘림 (두 배씩, FDCOUNT_LIMIT까지)
+/// @return 성공 시 true, 한계에 도달했거나 메모리가 없으면 false
+/// 테이블과 비트맵은 한 블록으로 할당하며, 새 칸은 모두 비어 있음
+static bool fd_table_grow(struct thread *t, int cap)
+{
+	int new_cap = t->fd_cap;
+	size_t words;
+	struct file **table;
+	uint64_t *map;
+
+	if (cap > FDCOUNT_LIMIT)
+		return false;
+	while (new_cap < cap)
+		new_cap = new_cap * 2 < FDCOUNT_LIMIT ? new_cap * 2 : FDCOUNT_LIMIT;
+
+	words = DIV_ROUND_UP(new_cap, 64);
+	table = calloc(1, new_cap * sizeof *table + words * sizeof *map);
+	if (table == NULL)
+		return false;
+	map = (uint64_t *) (table + new_cap);
+
+	memcpy(table, t->fd_table, t->fd_cap * sizeof *table);
+	memcpy(map, t->fd_map, DIV_ROUND_UP(t->fd_cap, 64) * sizeof *map);
+	if (t->fd_table != t->fd_inline)
+		free(t->fd_table);
+
+	t->fd_table = table;
+	t->fd_map = map;
+	t->fd_cap = new_cap;
+	return true;
+}
+
+/// @brief 부모 PARENT의 열린 파일을 모두 복제해 자식 CHILD의 같은 fd에 넣음
+/// @return 성공 시 true, 메모리 부족 시 false
+static bool fd_table_copy(struct thread *child, struct thread *parent)
+{
+	if (parent->fd_cap > child->fd_cap && !fd_table_grow(child, parent->fd_cap))
+		return false;
+
+	for (int fd = 3; fd < parent->fd_cap; fd++) // 부모의 테이블을 순회하면서
+	{
+		if (parent->fd_table[fd] == NULL) // NULL인건 건너뛰고
+			continue;
+
+		child->fd_table[fd] = file_duplicate(parent->fd_table[fd]); // 자식의 파일에 부모의 파일을 복사
+		if (child->fd_table[fd] == NULL)
+			return false;
+		child->fd_map[fd / 64] |= 1ULL << (fd % 64);
+	}
+	return true;
+}
+
 /// @brief 현재 스레드의 파일 디스크립터 테이블에 파일을 추가하는 함수
 /// @param file 넣을 파일
-/// @return 성공 시 table 인덱스 반환, 실패 시 -1 반환
+/// @return 성공 시 사용 가능한 가장 작은 fd 반환, 실패 시 -1 반환
 int process_add_file(struct file *file)
 {
 	if (file == NULL)
 		return -1;
 	
 	struct thread *cur_thread = thread_current();
-	
-	if (cur_thread->fd_index >= FDCOUNT_LIMIT)
-		return -1;
-	
-	cur_thread->fd_table[cur_thread->fd_index++] = file;
+	int fd = -1;
+
+	// 비트맵에서 꺼진 비트를 워드 단위로 찾아 가장 작은 빈 fd를 고름
+	for (int w = 0; w * 64 < cur_thread->fd_cap; w++)
+		if (cur_thread->fd_map[w] != UINT64_MAX)
+		{
+			fd = w * 64 + __builtin_ctzll(~cur_thread->fd_map[w]);
+			break;
+		}
+
+	// 빈 칸이 없으면 테이블을 늘림
+	if (fd < 0 || fd >= cur_thread->fd_cap)
+	{
+		fd = cur_thread->fd_cap;
+		if (!fd_table_grow(cur_thread, fd + 1))
+			return -1;
+	}
+
+	cur_thread->fd_table[fd] = file;
+	cur_thread->fd_map[fd / 64] |= 1ULL << (fd % 64);
 
-	return cur_thread->fd_index - 1;
+	return fd;
 }
 
 /// @brief 현재 스레드의 fd번째 파일 정보 얻는 함수
@@ -476,7 +626,7 @@ struct file* process_get_file(int fd)
 	struct thread *cur_thread = thread_current();
 
 	// fd가 유효 범위 밖이거나, fd 가 3보다 작거나, fd_table[fd]가 NULL이라면
-	if (fd >= FDCOUNT_LIMIT || fd < 3 || cur_thread->fd_table[fd] == NULL) 
+	if (fd >= cur_thread->fd_cap || fd < 3 || cur_thread->fd_table[fd] == NULL) 
 		return NULL; // NULL 반환
 	
 	return cur_thread->fd_table[fd];
@@ -489,13 +639,14 @@ int process_close_file(int fd)
 {
 	struct thread *cur_thread = thread_current();
 
-	if (fd >= FDCOUNT_LIMIT || fd < 3 || cur_thread->fd_table[fd] == NULL) 
+	if (fd >= cur_thread->fd_cap || fd < 3 || cur_thread->fd_table[fd] == NULL) 
 	{
 		return -1;
 	}
 	else
 	{
 		cur_thread->fd_table[fd] = NULL;
+		cur_thread->fd_map[fd / 64] &= ~(1ULL << (fd % 64)); // 다음 open이 재사용할 수 있도록
 		return 0;
 	}
 }
@@ -832,7 +983,7 @@ install_page (void *upage, void *kpage, bool writable) {
  * @return 성공 시 true, 실패 시 false
  * @note 이 함수는 페이지 폴트 핸들러에서 호출됨
  * @note aux는 segment_info 구조체로 캐스팅하여 사용
- * @note 파일 읽기 후 반드시 file_close()와 free() 호출하여 리소스 정리
+ * @note 파일 읽기 후 반드시 file_close()와 kmem_cache_free() 호출하여 리소스 정리
  */
 bool lazy_load_segment(struct page *page, void *aux) {
     /* TODO: Load the segment from the file */
@@ -849,13 +1000,13 @@ bool lazy_load_segment(struct page *page, void *aux) {
     
     if (file_read_at(file, kva, page_read_bytes, ofs) != (int)page_read_bytes) {
         file_close(file);
-        free(segment_info);
+        kmem_cache_free(&segment_info_cache, segment_info);
         return false; 
     }
     
     memset(kva + page_read_bytes, 0, page_zero_bytes);
     
-    free(segment_info);
+    kmem_cache_free(&segment_info_cache, segment_info);
 	return true;
 }
 
@@ -916,7 +1067,7 @@ static bool load_segment(struct file *file, off_t ofs, uint8_t *upage, uint32_t
         size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
         size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
-        struct segment_info *aux = malloc(sizeof(struct segment_info));
+        struct segment_info *aux = kmem_cache_alloc(&segment_info_cache);
 
         if (aux == NULL) {
             return false;
@@ -930,7 +1081,7 @@ static bool load_segment(struct file *file, off_t ofs, uint8_t *upage, uint32_t
         /* TODO: Set up aux to pass information to the lazy_load_segment. */
         if (!vm_alloc_page_with_initializer(VM_ANON, upage, writable, lazy_load_segment, aux)){
             file_close(aux->file);
-            free(aux);
+            kmem_cache_free(&segment_info_cache, aux);
             return false;
         }
 
@@ -23,7 +23,7 @@ void syscall_entry (void);
 void syscall_handler (struct intr_frame *);
 void *mmap_(void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap_(void *addr);
-struct lock filesys_lock; // 파일 읽기 쓰기 lock
+struct rwlock filesys_lock; // 파일 시스템 rwlock (조회는 읽기, 변경은 쓰기)
 
 /* System call.
  *
@@ -50,7 +50,8 @@ syscall_init (void) {
 	write_msr(MSR_SYSCALL_MASK,
 			FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
 		
-	lock_init(&filesys_lock);
+	rwlock_init(&filesys_lock);
+	rwlock_set_name(&filesys_lock, "filesys_lock");
 }
 
 /* The main system call interface */
@@ -112,6 +113,18 @@ void syscall_handler (struct intr_frame *f UNUSED)
 	case SYS_MUNMAP:
 		munmap_(f->R.rdi);
 		break;
+	case SYS_GETNICE:
+		f->R.rax = getnice_();
+		break;
+	case SYS_SETNICE:
+		setnice_(f->R.rdi);
+		break;
+	case SYS_GETPRIORITY:
+		f->R.rax = getpriority_();
+		break;
+	case SYS_SETPRIORITY:
+		setpriority_(f->R.rdi);
+		break;
 	default:
 		exit_(-1);
 		break;
@@ -218,9 +231,9 @@ int wait_(pid_t pid)
 bool create_(const char *file, unsigned initial_size)
 {
 	check_address(file);
-	lock_acquire(&filesys_lock);
+	rwlock_acquire_write(&filesys_lock);
 	bool result = filesys_create(file, initial_size);
-	lock_release(&filesys_lock);
+	rwlock_release_write(&filesys_lock);
 	// 주어진 이름과 초기 크기로 새로운 파일 생성하는 함수
 	return result;
 }
@@ -228,9 +241,9 @@ bool create_(const char *file, unsigned initial_size)
 bool remove_(const char *file)
 {
 	check_address(file);
-	lock_acquire(&filesys_lock);
+	rwlock_acquire_write(&filesys_lock);
 	bool result = filesys_remove(file);
-	lock_release(&filesys_lock);
+	rwlock_release_write(&filesys_lock);
 	// 주어진 이름의 파일 삭제하는 함수
 	return result;
 }
@@ -239,7 +252,9 @@ int open_(const char *file)
 {
 	check_address(file);
 	
+	rwlock_acquire_read(&filesys_lock); // 조회만 하므로 다른 open/read와 함께 진행
 	struct file *open_file = filesys_open(file);
+	rwlock_release_read(&filesys_lock);
 	
 	if (open_file == NULL)
 		return -1;
@@ -259,7 +274,10 @@ int filesize_(int fd)
 	if (file == NULL || fd < 3)
 		return;
 	
-	return file_length(file);
+	rwlock_acquire_read(&filesys_lock);
+	int length = file_length(file);
+	rwlock_release_read(&filesys_lock);
+	return length;
 }
 
 int read_(int fd, void *buffer, unsigned size)
@@ -292,9 +310,9 @@ int read_(int fd, void *buffer, unsigned size)
 		if (file == NULL)
 			return -1;
 		
-		lock_acquire(&filesys_lock); // race condition 방지를 위해 잠금
+		rwlock_acquire_read(&filesys_lock); // 읽기끼리는 동시에 진행, 쓰기와는 배타
 		read_bytes = file_read(file, buffer, size);
-		lock_release(&filesys_lock); // 해제
+		rwlock_release_read(&filesys_lock); // 해제
 		return read_bytes;
 	}
 }
@@ -320,9 +338,9 @@ int write_(int fd, const void *buffer, unsigned size)
 		if (file == NULL)
 			return -1;
 
-		lock_acquire(&filesys_lock); // race condition 방지 락
+		rwlock_acquire_write(&filesys_lock); // race condition 방지 락
 		write_bytes = file_write(file, buffer, size);
-		lock_release(&filesys_lock); // 락 해제
+		rwlock_release_write(&filesys_lock); // 락 해제
 		
 		return write_bytes;
 	}
@@ -359,6 +377,34 @@ void close_(int fd)
 	file_close(file);
 }
 
+int getnice_(void)
+{
+	return thread_get_nice();
+}
+
+void setnice_(int nice)
+{
+	// 범위를 벗어난 nice 값은 무시
+	if (nice < NICE_MIN || nice > NICE_MAX)
+		return;
+
+	thread_set_nice(nice);
+}
+
+int getpriority_(void)
+{
+	return thread_get_priority();
+}
+
+void setpriority_(int priority)
+{
+	// 범위를 벗어난 우선순위는 무시 (4.4BSD 스케줄러에서는 thread_set_priority가 무시함)
+	if (priority < PRI_MIN || priority > PRI_MAX)
+		return;
+
+	thread_set_priority(priority);
+}
+
 /**
  * @brief 메모리 매핑 시스템 콜
  * 
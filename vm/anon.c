@@ -49,6 +49,7 @@ void vm_anon_init(void) {
 
     //(필요시) 스왑 관리를 위한 락을 초기화
     lock_init(&swap_lock);
+    lock_set_name(&swap_lock, "swap_lock");
 }
 
 /*
@@ -123,9 +123,9 @@ do_mmap (void *addr, size_t length, int writable,
 	// TODO: 2. fd에 대응하는 struct file * 구하기
 	// - 열린 파일 디스크립터 테이블에서 찾고, 실패 시 NULL 반환
 	// - file을 reopen하여 별도 참조를 유지 (중복 닫힘 방지)
-	lock_acquire(&filesys_lock);
+	rwlock_acquire_read(&filesys_lock);
 	struct file *f = file_reopen(file);
-	lock_release(&filesys_lock);
+	rwlock_release_read(&filesys_lock);
 	int total_page_count = length / PGSIZE;
 	if (length % PGSIZE != 0)
 		total_page_count += 1;
@@ -164,7 +164,7 @@ do_mmap (void *addr, size_t length, int writable,
 		size_t page_zero_bytes = PGSIZE - page_read_bytes;
 	
 		/* TODO: Set up aux to pass information to the lazy_load_segment. */
-		struct segment_info *segment_info = (struct segment_info *)malloc(sizeof(struct segment_info));
+		struct segment_info *segment_info = kmem_cache_alloc(&segment_info_cache);
 		segment_info->file = f;					 // 내용이 담긴 파일 객체
 		segment_info->ofs = offset;					 // 이 페이지에서 읽기 시작할 위치
 		segment_info->page_read_bytes = page_read_bytes; // 이 페이지에서 읽어야 하는 바이트 수
@@ -16,6 +16,11 @@
 /* Global frame table */
 struct list frame_table;
 
+/* Object caches for the per-page structures. */
+static struct kmem_cache page_cache;
+static struct kmem_cache frame_cache;
+struct kmem_cache segment_info_cache;
+
 
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
@@ -29,6 +34,9 @@ void vm_init(void) {
     /* DO NOT MODIFY UPPER LINES. */
     /* TODO: Your code goes here. */
     list_init(&frame_table);
+    kmem_cache_init(&page_cache, "page", sizeof(struct page), 0, NULL);
+    kmem_cache_init(&frame_cache, "frame", sizeof(struct frame), 0, NULL);
+    kmem_cache_init(&segment_info_cache, "segment_info", sizeof(struct segment_info), 0, NULL);
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -77,7 +85,7 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
     /* Check wheter the upage is already occupied or not. */
     if (spt_find_page(spt, upage) == NULL) {
         // TODO: Create the page, fetch the initialier according to the VM type,
-        struct page *page = (struct page *) malloc(sizeof(struct page));
+        struct page *page = kmem_cache_alloc(&page_cache);
         
         if (page == NULL)
             goto err;
@@ -92,7 +100,7 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
                 page_initailizer = file_backed_initializer;
                 break;  
             default:
-                free(page);
+                kmem_cache_free(&page_cache, page);
                 goto err;
         }
 
@@ -103,7 +111,7 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
         
         // TODO: Insert the page into the spt.
         if (!spt_insert_page(spt, page)) {
-            free(page);
+            kmem_cache_free(&page_cache, page);
             goto err;
         }
 
@@ -235,7 +243,7 @@ static struct frame *vm_get_frame(void) {
     kpage = palloc_get_page(PAL_USER);
     
     if (kpage != NULL) {
-        frame = (struct frame *)malloc(sizeof(struct frame));
+        frame = kmem_cache_alloc(&frame_cache);
         if (frame == NULL) {
             palloc_free_page(kpage);  // 메모리 누수 방지
             PANIC("Failed to allocate frame struct");
@@ -328,7 +336,7 @@ bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user,
  * DO NOT MODIFY THIS FUNCTION. */
 void vm_dealloc_page(struct page *page) {
     destroy(page);
-    free(page);
+    kmem_cache_free(&page_cache, page);
 }
 
 void vm_dealloc_frame(struct frame *frame) {
@@ -339,7 +347,7 @@ void vm_dealloc_frame(struct frame *frame) {
     palloc_free_page(frame);
     list_remove(&frame->frame_elem);
     frame->page = NULL;
-    free(frame);
+    kmem_cache_free(&frame_cache, frame);
 }
 
 /* Claim the page that allocate on VA. */
@@ -444,14 +452,14 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst, struct su
                 goto err;
         }
         else if (parent_type == VM_FILE){
-			struct segment_info *file_aux = malloc(sizeof(struct segment_info));
+			struct segment_info *file_aux = kmem_cache_alloc(&segment_info_cache);
             file_aux->file = parent_page->file.file;
             file_aux->ofs = parent_page->file.ofs;
             file_aux->page_read_bytes = parent_page->file.read_bytes;
             file_aux->page_zero_bytes = parent_page->file.zero_bytes;
 
             if (!vm_alloc_page_with_initializer(parent_type, parent_page->va, parent_page->writable, NULL, file_aux)) {
-                free(file_aux);
+                kmem_cache_free(&segment_info_cache, file_aux);
                 goto err;
             }
 
@@ -518,5 +526,5 @@ void supplemental_page_table_kill(struct supplemental_page_table *spt) {
 void page_destory(struct hash_elem *elem) {
     struct page *page = hash_entry(elem, struct page, hash_elem);
     destroy(page);
-    free(page);
+    kmem_cache_free(&page_cache, page);
 }
\ No newline at end of file